@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file arena.h
+ *
+ * @brief Memory that is freed all at once
+ *
+ * The memory is taken from chunks, one piece after another, and
+ * nothing is freed until the arena is reset, which makes every chunk
+ * available again at once.  The chunks are kept, so once the arena is
+ * big enough for a turn, the next turns allocate nothing.
+ *
+ * @code
+ * arena_t *arena = arena_init(ARENA_CHUNK);
+ * char *word = arena_strndup(arena, "key", 3);
+ * arena_reset(arena);      // word is no longer valid
+ * @endcode
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+/* System includes */
+#include <stdalign.h>   /* alignas */
+#include <stddef.h>     /* max_align_t, size_t */
+
+#define ARENA_CHUNK  (16 * 1024)    /**< Usual size of a chunk */
+
+
+/**
+ * @typedef arena_chunk_t
+ *
+ * @brief Chunk of memory of an arena
+ */
+typedef struct arena_chunk {
+    struct arena_chunk *next;   /**< Next chunk */
+    size_t size;                /**< Bytes in @e data */
+    size_t used;                /**< Bytes already given */
+    alignas(max_align_t) char data[];   /**< Memory */
+} arena_chunk_t;
+
+
+/**
+ * @typedef arena_t
+ *
+ * @brief Arena, as a list of chunks
+ */
+typedef struct {
+    arena_chunk_t *head;    /**< First chunk */
+    arena_chunk_t *cur;     /**< Chunk where the memory is taken from */
+    size_t chunk;           /**< Size of a new chunk */
+} arena_t;
+
+
+/* Public interface */
+/**
+ * @brief Creates an empty arena
+ *
+ * @param chunk Size of the chunks, usually @c ARENA_CHUNK
+ *
+ * @return Pointer to the arena, or @c NULL if it can't allocate memory
+ */
+arena_t *arena_init(size_t chunk);
+
+/**
+ * @brief Frees the arena and all its memory
+ *
+ * @param arena Arena to destroy
+ */
+void arena_destroy(arena_t *arena);
+
+/**
+ * @brief Takes memory from an arena, aligned for any type
+ *
+ * @param arena Arena
+ * @param size  Number of bytes
+ *
+ * @return Pointer to the memory, or @c NULL if it can't allocate memory
+ */
+void *arena_alloc(arena_t *arena, size_t size);
+
+/**
+ * @brief Copies a string into an arena
+ *
+ * @param arena Arena
+ * @param s     String (not necessarily null-terminated)
+ * @param len   Length of the string
+ *
+ * @return Null-terminated copy, or @c NULL if it can't allocate memory
+ */
+char *arena_strndup(arena_t *arena, const char *s, size_t len);
+
+/**
+ * @brief Gives back all the memory of an arena at once, keeping its
+ *        chunks
+ *
+ * @param arena Arena to reset
+ */
+void arena_reset(arena_t *arena);
+
+/**
+ * @brief Gets the number of bytes given by the arena since it was reset
+ *
+ * @param arena Arena
+ *
+ * @return Bytes in use
+ */
+size_t arena_used(const arena_t *arena);
+
+
+#endif /* ARENA_H */
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file atom.h
+ *
+ * @brief Global table of interned words
+ *
+ * Every different word is stored only once, and it's identified by a
+ * small number, its atom, so comparing two words is comparing two
+ * integers.
+ *
+ * The words of the lexicon are atoms from the beginning: the atom of
+ * a word of the lexicon is the index of its entry plus one, the same
+ * number the tokenizer gives for every token, so parsing a sentence
+ * gives atoms without looking anything up.  Any other word gets the
+ * next free atom when it's interned.
+ *
+ * Words are folded to lowercase (ASCII) before looking them up, as the
+ * tokenizer does, so "Key", "KEY" and a parsed "key" are the same atom,
+ * and @e atom_str gives the lowercase word.
+ *
+ * @code
+ * atom_t key = atom_intern_str("key");
+ * atom_str(key);   // "key"
+ * @endcode
+ *
+ * @note The atoms are bound to the lexicon of the parser, so the
+ *       parser must be set up with @e parser_init or @e parser_load
+ *       before interning any word (until then every word is
+ *       @c ATOM_NONE), and the atoms are no longer valid after
+ *       @e parser_destroy
+ */
+
+#ifndef ATOM_H
+#define ATOM_H
+
+/* System includes */
+#include <stdbool.h>    /* bool */
+#include <stddef.h>     /* size_t */
+#include <stdint.h>     /* uint32_t */
+#include <string.h>     /* strlen */
+
+/* Local includes */
+#include <lexicon.h>
+
+#define ATOM_NONE  (0)  /**< No word */
+
+
+/**
+ * @typedef atom_t
+ *
+ * @brief Identifier of an interned word
+ */
+typedef uint32_t atom_t;
+
+
+/* Public interface */
+/**
+ * @brief Binds the table of atoms to a lexicon
+ *
+ * @param lexicon Lexicon whose words are the first atoms
+ *
+ * @return Returns 0 on success, or 1 if it can't allocate memory
+ *
+ * @note Called by the parser when its lexicon is ready
+ */
+int atom_init(const lexicon_t *lexicon);
+
+/**
+ * @brief Forgets every atom and frees allocated memory
+ *
+ * @note Called by the parser when its lexicon is destroyed
+ */
+void atom_destroy(void);
+
+/**
+ * @brief Checks if some atom has been given since the table was bound
+ *
+ * @return @c true if @e atom_intern or @e atom_find gave some atom
+ *
+ * @note While atoms are in use, the lexicon can't be changed, as it
+ *       would change the words of the atoms already stored
+ */
+bool atom_in_use(void);
+
+/**
+ * @brief Gets the atom of a word, interning it if it's new
+ *
+ * @param s   Word (not necessarily null-terminated)
+ * @param len Length of the word
+ *
+ * @return Atom of the word, or @c ATOM_NONE if the word is empty, there
+ *         is no lexicon or it can't allocate memory
+ */
+atom_t atom_intern(const char *s, size_t len);
+
+/**
+ * @brief Gets the atom of a word only if it's already interned
+ *
+ * @param s   Word (not necessarily null-terminated)
+ * @param len Length of the word
+ *
+ * @return Atom of the word, or @c ATOM_NONE if not interned or there is
+ *         no lexicon
+ */
+atom_t atom_find(const char *s, size_t len);
+
+/**
+ * @brief Gets the word of an atom
+ *
+ * @param atom Atom
+ *
+ * @return Null-terminated word, or @c NULL if the atom doesn't exist
+ */
+const char *atom_str(atom_t atom);
+
+/**
+ * @brief Gets the length of the word of an atom
+ *
+ * @param atom Atom
+ *
+ * @return Length of the word, or 0 if the atom doesn't exist
+ */
+size_t atom_len(atom_t atom);
+
+/**
+ * @brief Macro that evaluates to @e atom_intern of a null-terminated
+ *        string
+ */
+#define atom_intern_str(s)  atom_intern(s, strlen(s))
+
+/**
+ * @brief Macro that evaluates to @e atom_find of a null-terminated
+ *        string
+ */
+#define atom_find_str(s)  atom_find(s, strlen(s))
+
+
+#endif /* ATOM_H */
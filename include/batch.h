@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file batch.h
+ *
+ * @brief Parses many lines at once using several threads
+ *
+ * Intended for offline processing, such as going through transcripts
+ * of played games.  Since the lexicon is only read while parsing, the
+ * lines are shared among threads without any lock: every thread takes
+ * the next chunk of lines still not parsed, until there are no more.
+ * The results are always stored (or delivered) in the same order as
+ * the lines.
+ *
+ * @code
+ * void show(size_t lineno, span_t line, const cmdlist_t *list, void *data)
+ * {
+ *     printf("%zu: %zu command(s)\n", lineno, list->len);
+ * }
+ *
+ * batch_parse_file("transcript.txt", 0, show, NULL);
+ * @endcode
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+/* System includes */
+#include <stddef.h>     /* size_t */
+
+/* Local includes */
+#include <cmd.h>
+#include <strops.h>
+
+#define BATCH_CHUNK   (64)      /**< Lines taken by a thread at once */
+#define BATCH_WINDOW  (8192)    /**< Lines of a file parsed at once */
+#define BATCH_THREADS_MAX  (1024)   /**< Most threads of a batch */
+
+
+/**
+ * @typedef batch_cb_t
+ *
+ * @brief Function called for every line parsed from a file
+ *
+ * The arguments are the line number (starting at 1), the line (without
+ * the end of line), the commands found in it and the user data.
+ */
+typedef void (*batch_cb_t)(size_t lineno, span_t line,
+                           const cmdlist_t *list, void *data);
+
+
+/* Public interface */
+/**
+ * @brief Parses an array of lines
+ *
+ * @param lines    Lines to parse
+ * @param n        Number of lines
+ * @param results  Where to store the commands of every line, must have
+ *                 room for @e n lists
+ * @param nthreads Number of threads to use, up to
+ *                 @c BATCH_THREADS_MAX, or 0 to use one per core
+ *
+ * @return Returns 0 if every line is parsed,
+ *                 1 if the parser or the threads can't be initialized
+ *
+ * @see parse_line
+ */
+int batch_parse(const span_t *lines, size_t n, cmdlist_t *results,
+                unsigned nthreads);
+
+/**
+ * @brief Parses every line of a file
+ *
+ * The file is mapped in memory and it's never copied: the lines given
+ * to @e f are chunks of the mapping.
+ *
+ * @param path     Path of the file to parse
+ * @param nthreads Number of threads to use, up to
+ *                 @c BATCH_THREADS_MAX, or 0 to use one per core
+ * @param f        Function called for every line, in order
+ * @param data     User data passed to @e f
+ *
+ * @return Returns 0 if every line is parsed,
+ *                 1 if the parser or the threads can't be initialized,
+ *                 2 if the file can't be read
+ */
+int batch_parse_file(const char *path, unsigned nthreads, batch_cb_t f,
+                     void *data);
+
+
+#endif /* BATCH_H */
@@ -23,10 +23,13 @@
 /* System includes */
 #include <stdbool.h>    /* bool */
 #include <stddef.h>     /* NULL */
+#include <string.h>     /* memset */
 
 /* Local includes */
+#include <atom.h>
 #include <strops.h>
 
+#define CMD_LIST_MAX  (16)  /**< Maximum commands in a sentence */
 
 /**
  * @typedef cmd_t
@@ -65,20 +68,79 @@
  *
  * Prepositions, articles and conjunctions are ignored, except 'and' to
  * couple several actions into one, eg, "LOOK ROOM AND TAKE KEY".
+ *
+ * Every part is an atom, so matching a command against the words of
+ * an item is comparing integers.  A part not present is @c ATOM_NONE.
+ *
+ * @see atom_t
  */
 typedef struct {
-    char *action;   /**< Action (verb) */
-    char *mode;     /**< Way this action is performed (adverb) */
-    char *quantity; /**< Number of the object (adjective in partitive sense) */
-    char *quality;  /**< Quality of the object (adjective) */
-    char *dobj;     /**< Direct object (common nouns) */
-    char *iobj;     /**< Indirect object (proper nouns and pronouns) */
+    atom_t action;      /**< Action (verb) */
+    atom_t mode;        /**< Way this action is performed (adverb) */
+    atom_t quantity;    /**< Number of the object (adjective in partitive
+                             sense) */
+    atom_t quality;     /**< Quality of the object (adjective) */
+    atom_t dobj;        /**< Direct object (common nouns) */
+    atom_t iobj;        /**< Indirect object (proper nouns and pronouns) */
 } cmd_t;
 
 
+/**
+ * @typedef cword_t
+ *
+ * @brief Word of a command, as found in the sentence
+ */
+typedef struct {
+    span_t span;    /**< The word, as a chunk of the sentence */
+    atom_t atom;    /**< Atom of the word */
+} cword_t;
+
+
+/**
+ * @typedef cmdv_t
+ *
+ * @brief View of a command over the sentence where it was found
+ *
+ * It has the same parts as @e cmd_t, and every part keeps also the
+ * chunk of the sentence where the word was found, so filling it needs
+ * no memory allocation.  A part not present in the sentence has length
+ * 0 and atom @c ATOM_NONE.
+ *
+ * The chunks are valid as long as the sentence is; to keep the command
+ * for longer, make a copy with @e cmd_init_view.
+ *
+ * @see cmd_t, cword_t
+ */
+typedef struct {
+    cword_t action;     /**< Action (verb) */
+    cword_t mode;       /**< Way this action is performed (adverb) */
+    cword_t quantity;   /**< Number of the object */
+    cword_t quality;    /**< Quality of the object (adjective) */
+    cword_t dobj;       /**< Direct object (common nouns) */
+    cword_t iobj;       /**< Indirect object (proper nouns and pronouns) */
+    span_t unknown;     /**< First word not understood, if any */
+} cmdv_t;
+
+
+/**
+ * @typedef cmdlist_t
+ *
+ * @brief Commands found in a compound sentence, in order
+ *
+ * The number of commands is bounded by @c CMD_LIST_MAX, so the list
+ * can live on the stack.  When a sentence has more commands, the rest
+ * are dropped and @e overflow is set.
+ */
+typedef struct {
+    cmdv_t cmds[CMD_LIST_MAX];  /**< Commands */
+    size_t len;                 /**< Number of commands */
+    bool overflow;              /**< There were more commands than room */
+} cmdlist_t;
+
+
 /* Public interface */
 /**
- * @brief Initializes a command allocating needed memory
+ * @brief Initializes a command interning every word
  *
  * @param action   Verb
  * @param mode     Adverb
@@ -93,6 +155,17 @@ cmd_t *cmd_init(const char *action, const char *mode,
                 const char *quantity, const char *quality,
                 const char *dobj, const char *iobj);
 
+/**
+ * @brief Initializes a command with the atoms of a command view
+ *
+ * @param view Command view to copy
+ *
+ * @return Pointer to the newly created command, or @c NULL otherwise
+ *
+ * @see cmd_init, cmdv_t
+ */
+cmd_t *cmd_init_view(const cmdv_t *view);
+
 /**
  * @brief Frees allocated memory for a previously allocated command
  *
@@ -101,16 +174,14 @@ cmd_t *cmd_init(const char *action, const char *mode,
 void cmd_destroy(cmd_t *cmd);
 
 /**
- * @brief Macro that evaluates to the command emptyness (or null-ness)
- *
- * @see str_is_empty_or_null
+ * @brief Macro that evaluates to the command emptyness
  */
-#define cmd_is_empty(cmd)  (str_is_empty_or_null(cmd->action) && \
-                            str_is_empty_or_null(cmd->mode) && \
-                            str_is_empty_or_null(cmd->quantity) && \
-                            str_is_empty_or_null(cmd->quality) && \
-                            str_is_empty_or_null(cmd->dobj) && \
-                            str_is_empty_or_null(cmd->iobj))
+#define cmd_is_empty(cmd)  (cmd->action == ATOM_NONE && \
+                            cmd->mode == ATOM_NONE && \
+                            cmd->quantity == ATOM_NONE && \
+                            cmd->quality == ATOM_NONE && \
+                            cmd->dobj == ATOM_NONE && \
+                            cmd->iobj == ATOM_NONE)
 
 /**
  * @brief Macro that evaluates to the creation of an empty command
@@ -119,6 +190,28 @@ void cmd_destroy(cmd_t *cmd);
  */
 #define cmd_init_empty()  cmd_init(NULL, NULL, NULL, NULL, NULL, NULL)
 
+/**
+ * @brief Macro that evaluates to the clearing of every part of a
+ *        command view
+ */
+#define cmdv_clear(v)  memset(v, 0, sizeof(cmdv_t))
+
+/**
+ * @brief Macro that evaluates to @c true if every word of the command
+ *        view was understood
+ */
+#define cmdv_is_valid(v)  ((v)->unknown.len == 0)
+
+/**
+ * @brief Macro that evaluates to the command view emptyness
+ */
+#define cmdv_is_empty(v)  ((v)->action.atom == ATOM_NONE && \
+                           (v)->mode.atom == ATOM_NONE && \
+                           (v)->quantity.atom == ATOM_NONE && \
+                           (v)->quality.atom == ATOM_NONE && \
+                           (v)->dobj.atom == ATOM_NONE && \
+                           (v)->iobj.atom == ATOM_NONE)
+
 /**
  * @brief Macro that evaluates to the command @e action 'property'
  */
@@ -15,6 +15,12 @@
  * @file flag.h
  *
  * @brief Flag routines
+ *
+ * Every flag is registered, when it's initialized, in a global
+ * registry that gives it a small dense identifier, so a set of flags
+ * can be a bitmap indexed by the identifiers of its flags.
+ *
+ * @see qltys.h
  */
 
 #ifndef FLAG_H
@@ -22,21 +28,27 @@
 
 /* System includes */
 #include <stdbool.h>    /* bool, true, false */
+#include <stdint.h>     /* uint32_t */
+
+#define FLAG_MAX  (256) /**< Maximum number of flags registered at once */
 
 
 /**
  * @typedef flag_t
  *
- * @brief Flag, defined with a boolean state and two strings depending
- *        on the state value
+ * @brief Flag, defined with a boolean initial state and two strings
+ *        depending on the state value
  *
- * @todo The strings should be in a `union` allocating memory for the
- *       longest
+ * A flag is only a definition: the actual state is kept by every set
+ * of qualities that has the flag, so a flag never changes once it's
+ * initialized.  The strings are shared by every flag with the same
+ * texts, so they must never be modified.
  */
 typedef struct {
-    bool state;   /**< Actual value of the flag */
-    char *yes;    /**< Text on positive case */
-    char *no;     /**< Text on negative case */
+    uint32_t id;        /**< Index in the registry, less than @c FLAG_MAX */
+    bool initial;       /**< State of the flag when added to qualities */
+    const char *yes;    /**< Text on positive case */
+    const char *no;     /**< Text on negative case */
 } flag_t;
 
 
@@ -44,39 +56,61 @@ typedef struct {
 /**
  * @brief Initializes the flag
  *
- * @param state  Flag effective value
- * @param yes    Text on affirmative case
- * @param no     Text on negative case
+ * @param state  State of the flag when it's added to qualities
+ * @param yes    Text on affirmative case, or @c NULL
+ * @param no     Text on negative case, or @c NULL
  *
- * @return Pointer to new flag, or @c NULL otherwise
+ * @return Pointer to new flag, or @c NULL if it can't allocate memory
+ *         or there are already @c FLAG_MAX flags registered
  */
 flag_t *flag_init(const bool state, const char *yes, const char *no);
 
 /**
- * @brief Frees allocated memory
+ * @brief Frees allocated memory, and frees its identifier
  *
  * @param flag Flag to deallocate from memory
+ *
+ * @warning The identifier can be given to a new flag, so the flag
+ *          must be removed from every set of qualities before
  */
 void flag_destroy(flag_t *flag);
 
+/**
+ * @brief Gets a registered flag by its identifier
+ *
+ * @param id Identifier of the flag
+ *
+ * @return Pointer to the flag, or @c NULL if there's no flag with that
+ *         identifier
+ */
+flag_t *flag_get(uint32_t id);
+
 /**
  * @brief Compares two flags
  *
  * @param f1       First flag to compare
  * @param f2       Second flag to compare
- * @param statecmp Compare also the state of the flag
+ * @param statecmp Compare also the initial state of the flag
  *
- * @return @c true if both flags have the same @e yes and @e no strings
+ * @return @c true if both flags have the same @e yes and @e no strings,
+ *         or if both flags are @c NULL
  *
- * @note The equality is based on string comparison, and it's always
- *       taken as a reference the length of the strings of @e f1
+ * @note As equal texts are shared, the strings are compared by their
+ *       addresses, not by their contents
  */
 bool flag_cmp(const flag_t *f1, const flag_t *f2, bool statecmp);
 
 /**
- * @brief Macro that evaluates to the flag effective value
+ * @brief Macro that evaluates to the flag identifier
+ */
+#define flag_id(f)  (f->id)
+
+/**
+ * @brief Macro that evaluates to the flag initial state
+ *
+ * @see qltys_state, for the actual state of the flag in an item
  */
-#define flag_state(f)  (f->state)
+#define flag_initial(f)  (f->initial)
 
 /**
  * @brief Macro that evaluates to the flag affirmative answer
@@ -88,11 +122,6 @@ bool flag_cmp(const flag_t *f1, const flag_t *f2, bool statecmp);
  */
 #define flag_no(f)  (f->no)
 
-/**
- * @brief Toggles flag value
- */
-#define flag_toggle(f)  (f->state = !(f->state))
-
 /**
  * @brief Macro that evaluates to @flag_init without status strings
  */
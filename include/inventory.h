@@ -22,16 +22,34 @@
 
 /* System includes */
 #include <stdbool.h>    /* bool */
+#include <stddef.h>     /* size_t */
+#include <stdint.h>     /* uint32_t */
 
 /* Local includes */
 #include <item.h>
 
 
+/**
+ * @typedef inv_slot_t
+ *
+ * @brief Entry of the index of an inventory
+ */
+typedef struct {
+    uint32_t id;    /**< Item identifier, 0 if the slot is empty */
+    uint32_t pos;   /**< Position of the item in the array */
+} inv_slot_t;
+
+
 /**
  * @typedef inv_t
  *
  * @brief Inventory structure as a dynamic array of pointer to items
  *
+ * The array doubles its capacity when it's full, and a hash table
+ * (open addressing, linear probing) maps the @e id of every item to
+ * its position in the array, so finding an item takes constant time
+ * no matter how many items the inventory has.
+ *
  * @note Instead of using a function to calcuate the weight by
  *       transversing all items in the dynamic array, the weight is
  *       stored as a variable only updated when modifying the contents
@@ -40,10 +58,26 @@
 typedef struct {
     item_t **items; /**< Array of pointer to items */
     size_t len;     /**< Length of the array */
-    float weight;   /**< Inventory weight in kg (sum of all contained items) */
+    size_t cap;     /**< Allocated length of the array */
+    inv_slot_t *index;  /**< Position of every item by @e id */
+    size_t index_cap;   /**< Size of the index, a power of two */
+    weight_t weight;    /**< Inventory weight in grams (sum of all items) */
 } inv_t;
 
 
+/**
+ * @typedef inv_pred_t
+ *
+ * @brief Condition on an item, used to choose items
+ *
+ * @param item Item to check
+ * @param data Data passed along with the condition
+ *
+ * @return @c true if the item is chosen
+ */
+typedef bool (*inv_pred_t)(const item_t *item, void *data);
+
+
 /* Public interface */
 /**
  * @brief Initializes a new empty inventory
@@ -90,8 +124,11 @@ bool inv_add(inv_t *inv, item_t *item);
 /**
  * @brief Removes an item from the inventory
  *
- * @param inv  Inventory where to remove the pointer to the item
- * @param item Pointer to the item to unlink from the inventory
+ * @param inv    Inventory where to remove the pointer to the item
+ * @param item   Pointer to the item to unlink from the inventory
+ * @param stable If @c true, the items after it keep their order, else
+ *               the last item takes its place, which takes constant
+ *               time
  *
  * @return @c true if the item was successfully removed, or @c false
  *         otherwise
@@ -103,39 +140,97 @@ bool inv_add(inv_t *inv, item_t *item);
  *       inventory, is the item to remove, this function checks if the
  *       item @e id matches
  *
- * @see inv_has_item
- *
- * @todo Refactor this function using @e memmove (@c string.h)
+ * @see inv_has_item, inv_rem, inv_rem_swap
  */
-bool inv_rem(inv_t *inv, item_t *item);
+bool inv_remove(inv_t *inv, item_t *item, bool stable);
 
 /**
  * @brief Moves an item from one inventory to another
  *
- * @param src  Pointer to source inventory, where the item is taken from
- * @param dest Pointer to destination inventory, where the item goes
- * @param item Pointer to the item to move
+ * @param src    Pointer to source inventory, where the item is taken
+ *               from
+ * @param dest   Pointer to destination inventory, where the item goes
+ * @param item   Pointer to the item to move
+ * @param stable Keep the order of the items left in @e src
  *
  * @return @c true if the transfer is succesful, or @c false otherwise
  *
- * @pre The same preconditions as @e inv_add and @e inv_rem
+ * @pre The same preconditions as @e inv_add and @e inv_remove
+ *
+ * @note Nothing changes if the item can't be added to @e dest
+ *
+ * @see inv_add, inv_remove, inv_transfer, inv_transfer_swap
+ */
+bool inv_move(inv_t *src, inv_t *dest, item_t *item, bool stable);
+
+/**
+ * @brief Moves several items from one inventory to another
+ *
+ * The room in @e dest is made once for all items, and the weight of
+ * each inventory is updated once.
+ *
+ * @param src    Pointer to source inventory, where the items are taken
+ *               from
+ * @param dest   Pointer to destination inventory, where the items go
+ * @param items  Array of pointers to the items to move
+ * @param n      Number of items in the array
+ * @param stable Keep the order of the items left in @e src
+ *
+ * @return Number of items moved; the items not in @e src, or already in
+ *         @e dest, are skipped
+ *
+ * @see inv_move
+ */
+size_t inv_move_many(inv_t *src, inv_t *dest, item_t **items, size_t n,
+                     bool stable);
+
+/**
+ * @brief Moves every item that meets a condition from one inventory to
+ *        another, keeping the order of the items in both of them
+ *
+ * @param src  Pointer to source inventory, where the items are taken
+ *             from
+ * @param dest Pointer to destination inventory, where the items go
+ * @param pred Condition, checked once for every item in @e src
+ * @param data Data passed to @e pred
  *
- * @note First removes the item from @e src, and if succeeds, the adds
- *       it to @e dest, in that order
+ * @return Number of items moved
  *
- * @see inv_add, inv_rem
+ * @see inv_move_many
  */
-bool inv_transfer(inv_t *src, inv_t *dest, item_t *item);
+size_t inv_move_if(inv_t *src, inv_t *dest, inv_pred_t pred, void *data);
+
+/**
+ * @brief Moves every item from one inventory to another, keeping their
+ *        order
+ *
+ * @param src  Pointer to source inventory, empty afterwards
+ * @param dest Pointer to destination inventory, where the items go
+ *
+ * @return Number of items moved; the items already in @e dest are just
+ *         removed from @e src
+ *
+ * @see inv_move_many
+ */
+size_t inv_clear_into(inv_t *src, inv_t *dest);
 
 /**
  * @brief Forces recaculation of weight to update the inventory weight
  *        "property"
  *
- * @param inv Inventory to calculate effective weight in kg
+ * @param inv Inventory to calculate effective weight in grams
  *
- * @return Sum of all of weights (kg) of items contained in the inventory
+ * @return Sum of all of weights of items contained in the inventory,
+ *         always the same as @e inv_weight_g
  */
-float inv_eval_weight(inv_t *inv);
+weight_t inv_eval_weight_g(inv_t *inv);
+
+/**
+ * @brief Macro that evaluates to the recalculated weight in kg
+ *
+ * @see inv_eval_weight_g
+ */
+#define inv_eval_weight(i)  weight_to_kg(inv_eval_weight_g(i))
 
 /**
  * @brief Macro that evaluates to a soft memory deallocation without
@@ -153,6 +248,37 @@ float inv_eval_weight(inv_t *inv);
  */
 #define inv_destroy_hard(i)  inv_destroy(i, true)
 
+/**
+ * @brief Macro that evaluates to the removal of an item keeping the
+ *        order of the rest
+ *
+ * @see inv_remove
+ */
+#define inv_rem(i, t)  inv_remove(i, t, true)
+
+/**
+ * @brief Macro that evaluates to the removal of an item in constant
+ *        time, moving the last item to its place
+ *
+ * @see inv_remove
+ */
+#define inv_rem_swap(i, t)  inv_remove(i, t, false)
+
+/**
+ * @brief Macro that evaluates to moving an item keeping the order of
+ *        the items left in the source inventory
+ *
+ * @see inv_move
+ */
+#define inv_transfer(s, d, t)  inv_move(s, d, t, true)
+
+/**
+ * @brief Macro that evaluates to moving an item in constant time
+ *
+ * @see inv_move
+ */
+#define inv_transfer_swap(s, d, t)  inv_move(s, d, t, false)
+
 /**
  * @brief Macro that evaluates to the inventory length (number of items
  *        that the inventory contains)
@@ -160,9 +286,16 @@ float inv_eval_weight(inv_t *inv);
 #define inv_len(i)  (i->len)
 
 /**
- * @brief Macro that evaluates to the inventory current weight
+ * @brief Macro that evaluates to the inventory current weight in kg,
+ *        as @e item_weight
+ */
+#define inv_weight(i)  weight_to_kg(i->weight)
+
+/**
+ * @brief Macro that evaluates to the exact inventory current weight,
+ *        in grams
  */
-#define inv_weight(i)  (i->weight)
+#define inv_weight_g(i)  (i->weight)
 
 
 #endif /* INVENTORY_H */
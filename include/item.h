@@ -46,12 +46,26 @@
 #define ITEM_H
 
 /* System includes */
-#include <stdint.h> /* uint32_t */
+#include <stdbool.h> /* bool */
+#include <stdint.h> /* int64_t, uint32_t */
 
 /* Local includes */
 #include <lingo.h>
 #include <qltys.h>
 
+#define WEIGHT_UNIT  (1000) /**< Units of @e weight_t in a kg (grams) */
+
+
+/**
+ * @typedef weight_t
+ *
+ * @brief Weight in grams
+ *
+ * Weights are integers so they can be added and subtracted any number
+ * of times without rounding errors.
+ */
+typedef int64_t weight_t;
+
 
 /**
  * @typedef item_t
@@ -84,9 +98,9 @@
  */
 typedef struct {
     uint32_t id;        /**< Item unique identifier */
-    float weight;       /**< Item weight in kg */
+    weight_t weight;    /**< Item weight */
     lingo_t *lingo;     /**< Syntax related strings */
-    qltys_t *qltys;     /**< List of qualities (flags/dyanmic adjs) */
+    qltys_t *qltys;     /**< Qualities (flags/dyanmic adjs), in the store */
 } item_t;
 
 
@@ -106,9 +120,94 @@ item_t *item_init(const char *name, const char *desc, float weight);
  * @brief Frees allocated memory
  *
  * @param item Item to deallocate
+ *
+ * @note The flags of the item are shared with other items, so they're
+ *       not destroyed
+ *
+ * @note The item is removed from the inventory where it is, as its
+ *       identifier is given to the next item created
  */
 void item_destroy(item_t *item);
 
+/**
+ * @brief Changes the weight of an item, and the weight of the
+ *        inventory where the item is
+ *
+ * @param item   Item
+ * @param weight New weight in kg
+ *
+ * @return @c true on success, or @c false otherwise
+ *
+ * @see store_set_weight
+ */
+bool item_set_weight(item_t *item, float weight);
+
+/**
+ * @brief Adds a noun to the item, and to the index of nouns
+ *
+ * @param item Item
+ * @param noun Noun to add
+ *
+ * @return @c true if the noun is added, or @c false otherwise
+ *
+ * @see wset_add, item_find
+ */
+bool item_add_noun(item_t *item, const char *noun);
+
+/**
+ * @brief Removes a noun from the item, and from the index of nouns
+ *
+ * @param item Item
+ * @param noun Noun to remove
+ *
+ * @return @c true if the noun is removed, or @c false otherwise
+ *
+ * @see wset_rem
+ */
+bool item_rem_noun(item_t *item, const char *noun);
+
+/**
+ * @brief Adds an adjective to the item, and to the index of adjectives
+ *
+ * @param item Item
+ * @param adj  Adjective to add
+ *
+ * @return @c true if the adjective is added, or @c false otherwise
+ *
+ * @see wset_add, item_find
+ */
+bool item_add_adj(item_t *item, const char *adj);
+
+/**
+ * @brief Removes an adjective from the item, and from the index of
+ *        adjectives
+ *
+ * @param item Item
+ * @param adj  Adjective to remove
+ *
+ * @return @c true if the adjective is removed, or @c false otherwise
+ *
+ * @see wset_rem
+ */
+bool item_rem_adj(item_t *item, const char *adj);
+
+/**
+ * @brief Finds the items that have a noun and an adjective
+ *
+ * @param noun  Noun, or @c ATOM_NONE for any
+ * @param adj   Adjective, or @c ATOM_NONE for any
+ * @param items Array where to save the items found, or @c NULL
+ * @param max   Length of the array
+ *
+ * @return Number of items found, that can be greater than @e max, as
+ *         only the first @e max items are saved, or 0 if both words
+ *         are @c ATOM_NONE
+ *
+ * @note Only the nouns and adjectives added with the functions of the
+ *       item are indexed, not those added to the sets directly
+ */
+size_t item_find(atom_t noun, atom_t adj, item_t **items, size_t max);
+
 /**
  * @brief Macro that evaluates to the item name
  */
@@ -122,7 +221,19 @@ void item_destroy(item_t *item);
 /**
  * @brief Macro that evaluates to the item weight in kg
  */
-#define item_weight(i)  (i->weight)
+#define item_weight(i)  weight_to_kg(i->weight)
+
+/**
+ * @brief Macro that evaluates to a weight in kg converted to
+ *        @e weight_t, rounded to the nearest gram
+ */
+#define weight_from_kg(kg)  \
+    ((weight_t) ((kg) * WEIGHT_UNIT + ((kg) < 0 ? -0.5 : 0.5)))
+
+/**
+ * @brief Macro that evaluates to a @e weight_t converted to kg
+ */
+#define weight_to_kg(w)  ((float) (w) / WEIGHT_UNIT)
 
 /**
  * @brief Macro that evaluates to the item unique numeric identifier
@@ -132,75 +243,73 @@ void item_destroy(item_t *item);
 /**
  * @brief Macro that evaluates to the linguistic nouns for this item
  */
-#define item_nouns(i)  (i->lingo->nouns)
+#define item_nouns(i)  (&i->lingo->nouns)
 
 /**
  * @brief Macro that evaluates to the linguistic adjectives for this item
  */
-#define item_adjs(i)  (i->lingo->adjs)
+#define item_adjs(i)  (&i->lingo->adjs)
 
 /**
  * @brief Macro that evaluates to the linguistic pronouns for this item
  */
-#define item_pronouns(i)  (i->lingo->pronouns)
+#define item_pronouns(i)  (&i->lingo->pronouns)
 
 /**
- * @brief Macro that evaluates to the adding of a noun
+ * @brief Macro that evaluates to @c true if the atom is a noun of the
+ *        item
  *
- * @see wset_add
+ * @see wset_has_atom
  */
-#define item_add_noun(i,s)  wset_add(i->lingo->nouns, s)
+#define item_has_noun(i,a)  wset_has_atom(&i->lingo->nouns, a)
 
 /**
- * @brief Macro that evaluates to the removal of a noun
+ * @brief Macro that evaluates to @c true if the atom is an adjective of
+ *        the item
  *
- * @see wset_rem
+ * @see wset_has_atom
  */
-#define item_rem_noun(i,s)  wset_rem(i->lingo->nouns, s)
+#define item_has_adj(i,a)  wset_has_atom(&i->lingo->adjs, a)
 
 /**
- * @brief Macro that evaluates to the adding of an adjective
+ * @brief Macro that evaluates to @c true if the atom is a pronoun of
+ *        the item
  *
- * @see wset_add
+ * @see wset_has_atom
  */
-#define item_add_adj(i,s)  wset_add(i->lingo->adjs, s)
-
-/**
- * @brief Macro that evaluates to the removal of an adjective
- *
- * @see wset_rem
- */
-#define item_rem_adj(i,s)  wset_rem(i->lingo->adjs, s)
+#define item_has_pronoun(i,a)  wset_has_atom(&i->lingo->pronouns, a)
 
 /**
  * @brief Macro that evaluates to the adding of a pronoun
  *
  * @see wset_add
  */
-#define item_add_pronoun(i,s)  wset_add(i->lingo->pronouns, s)
+#define item_add_pronoun(i,s)  wset_add(&i->lingo->pronouns, s)
 
 /**
  * @brief Macro that evaluates to the removal of a pronoun
  *
  * @see wset_rem
  */
-#define item_rem_pronoun(i,s)  wset_rem(i->lingo->pronouns, s)
+#define item_rem_pronoun(i,s)  wset_rem(&i->lingo->pronouns, s)
 
 /**
  * @brief Macro that evaluates to the replacement of an old noun for a
  *        new one
  *
- * @see wset_replace
+ * @see item_rem_noun, item_add_noun
  */
-#define item_replace_noun(i, os, ns)  wset_replace(i->lingo->nouns, os, ns)
+#define item_replace_noun(i, os, ns)  \
+    (item_rem_noun(i, os) && item_add_noun(i, ns))
 
 /**
  * @brief Macro that evaluates to the replacement of an old adjective
  *        for a new one
  *
- * @see wset_replace
+ * @see item_rem_adj, item_add_adj
  */
-#define item_replace_adj(i, os, ns)  wset_replace(i->lingo->adjs, os, ns)
+#define item_replace_adj(i, os, ns)  \
+    (item_rem_adj(i, os) && item_add_adj(i, ns))
 
 /**
  * @brief Macro that evaluates to the replacement of an old pronoun
@@ -208,13 +317,13 @@ void item_destroy(item_t *item);
  *
  * @see wset_replace
  */
-#define item_replace_pronoun(i, os, ns)  wset_replace(i->lingo->pronouns, os, ns)
+#define item_replace_pronoun(i, os, ns)  wset_replace(&i->lingo->pronouns, os, ns)
 
 /**
  * @brief Macro that evaluates to the adding of a new flag in the
  *        qualities array
  *
- * @see qltys_add
+ * @see qltys_add, flag_init
  */
 #define item_add_qlty(i, f)  qltys_add(i->qltys, f)
 
@@ -229,14 +338,24 @@ void item_destroy(item_t *item);
 /**
  * @brief Macro that evaluates to the toggling of a flag
  *
- * @see qltys_toggle_flag, flag_toggle
+ * @see qltys_toggle_flag
  */
 #define item_toggle_flag(i, f)  qltys_toggle_flag(i->qltys, f)
 
 /**
- * @brief Macro that evaluates to the next identifier value
+ * @brief Macro that evaluates to the state of a flag of the item
+ *
+ * @see qltys_state
+ */
+#define item_flag_state(i, f)  qltys_state(i->qltys, f)
+
+/**
+ * @brief Macro that evaluates to @c true if the item has every flag of
+ *        a pattern, and with the same state
+ *
+ * @see qltys_match
  */
-#define item_next_id  (++item_last_id)
+#define item_match_qltys(i, p)  qltys_match(i->qltys, p)
 
 
 #endif /* ITEM_H */
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file lexfile.h
+ *
+ * @brief Binary lexicon files, used in place once mapped in memory
+ *
+ * A lexicon file has the tables of a built lexicon and its tokenizer
+ * exactly as they are in memory, so loading it is just mapping the
+ * file: there's no parsing and no allocation per word, and the time to
+ * load it doesn't depend on the number of words.  The pages are
+ * shared by every process that maps the same file.
+ *
+ * The file is made of a header followed by these sections, in native
+ * byte order and aligned to 4 bytes:
+ *
+ * @verbatim
+ *
+ *    lexfile_header_t   header
+ *    lexentry_t         entries[len]
+ *    uint32_t           disp[nbuckets]
+ *    uint32_t           slots[nslots]
+ *    uint8_t            classes[256]
+ *    uint32_t           trans[nstates * nclasses]
+ *    uint32_t           accept[nstates]
+ *    char               pool[pool_len]
+ * @endverbatim
+ */
+
+#ifndef LEXFILE_H
+#define LEXFILE_H
+
+/* System includes */
+#include <stdbool.h>    /* bool */
+#include <stddef.h>     /* size_t */
+#include <stdint.h>     /* uint32_t */
+
+/* Local includes */
+#include <lexicon.h>
+#include <tokenizer.h>
+
+#define LEXFILE_MAGIC    "TXLX" /**< First bytes of every lexicon file */
+#define LEXFILE_VERSION  (1)    /**< Version of the file format */
+
+
+/**
+ * @typedef lexfile_header_t
+ *
+ * @brief Header of a lexicon file
+ */
+typedef struct {
+    char magic[4];      /**< Always @c LEXFILE_MAGIC */
+    uint32_t version;   /**< Always @c LEXFILE_VERSION */
+    uint32_t len;       /**< Number of words */
+    uint32_t nbuckets;  /**< Number of buckets of the perfect hash */
+    uint32_t nslots;    /**< Size of the perfect hash table */
+    uint32_t seed;      /**< Seed of the perfect hash function */
+    uint32_t nclasses;  /**< Number of character classes */
+    uint32_t nstates;   /**< Number of states of the tokenizer */
+    uint32_t pool_len;  /**< Bytes of the string pool */
+    uint32_t reserved;  /**< Unused, always 0 */
+} lexfile_header_t;
+
+
+/**
+ * @typedef lexfile_t
+ *
+ * @brief Lexicon and tokenizer mapped from a file
+ *
+ * The arrays of @e lexicon and @e tokenizer point inside the mapping,
+ * so they must not be destroyed with @e lexicon_destroy or
+ * @e tokenizer_destroy, but with @e lexfile_destroy.
+ */
+typedef struct {
+    lexicon_t lexicon;      /**< Lexicon, read only */
+    tokenizer_t tokenizer;  /**< Tokenizer, read only */
+    void *map;              /**< Mapping of the file */
+    size_t size;            /**< Size of the mapping */
+} lexfile_t;
+
+
+/* Public interface */
+/**
+ * @brief Maps a lexicon file in memory
+ *
+ * @param path Path of the file
+ *
+ * @return Pointer to the lexicon file, or @c NULL if the file can't be
+ *         read or it isn't a valid lexicon file
+ *
+ * @note Every index in the tables is checked once against the size of
+ *       its table, so a damaged file is refused instead of being read
+ *       out of bounds
+ */
+lexfile_t *lexfile_load(const char *path);
+
+/**
+ * @brief Unmaps a lexicon file and frees allocated memory
+ *
+ * @param lexfile Lexicon file to deallocate
+ */
+void lexfile_destroy(lexfile_t *lexfile);
+
+/**
+ * @brief Writes a lexicon and its tokenizer to a file
+ *
+ * @param path      Path of the file
+ * @param lexicon   Lexicon, already built
+ * @param tokenizer Tokenizer made from @e lexicon
+ *
+ * @return @c true if the file is written, or @c false otherwise
+ */
+bool lexfile_save(const char *path, const lexicon_t *lexicon,
+                  const tokenizer_t *tokenizer);
+
+
+#endif /* LEXFILE_H */
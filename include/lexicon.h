@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file lexicon.h
+ *
+ * @brief Dictionary of known words classified by lexeme type
+ *
+ * The lexicon is filled word by word with @e lexicon_add and then
+ * frozen with @e lexicon_build, that computes a perfect hash function
+ * for the set of words (hash and displace).  After that, looking up any
+ * word costs one hash of its bytes, one probe in the table and one
+ * comparison, no matter how many words are stored.
+ *
+ * When a word is added more than once, only the first one is kept, so
+ * the priority between lexeme types is given by the order of insertion.
+ *
+ * @code
+ * lexicon_t *lexicon = lexicon_init();
+ * lexicon_add(lexicon, "open", LEX_VERB);
+ * lexicon_add(lexicon, "key", LEX_NOUN);
+ * lexicon_build(lexicon);
+ * lexicon_type(lexicon, "key", 3);  // LEX_NOUN
+ * lexicon_destroy(lexicon);
+ * @endcode
+ */
+
+#ifndef LEXICON_H
+#define LEXICON_H
+
+/* System includes */
+#include <stdbool.h>    /* bool */
+#include <stddef.h>     /* size_t */
+#include <stdint.h>     /* uint16_t, uint32_t */
+
+
+/**
+ * @typedef lexeme_t
+ *
+ * @brief Types of lexemes
+ */
+typedef enum { LEX_END=-1,  /**< End of sentence, could be an error */
+               LEX_EMPTY=0, /**< Empty string */
+               LEX_ADJ,     /**< Adjective */
+               LEX_ADVERB,  /**< Verb */
+               LEX_ART,     /**< Article */
+               LEX_CONJ,    /**< Conjunction */
+               LEX_NOUN,    /**< Noun */
+               LEX_NUM,     /**< Number */
+               LEX_PREP,    /**< Preposition */
+               LEX_PRONOUN, /**< Pronoun */
+               LEX_VERB,    /**< Verb */
+               LEX_UNK=99,  /**< Extra / Unknown lexeme */
+} lexeme_t;
+
+
+/**
+ * @typedef lexentry_t
+ *
+ * @brief Word stored in the lexicon
+ */
+typedef struct {
+    uint32_t off;   /**< Offset of the word in the string pool */
+    uint16_t len;   /**< Length of the word in bytes */
+    int16_t lex;    /**< Lexeme type of the word (see @e lexeme_t) */
+} lexentry_t;
+
+
+/**
+ * @typedef lexicon_t
+ *
+ * @brief Set of words with their lexeme type and a perfect hash table
+ *        to look them up
+ *
+ * Every word is stored once in @e pool, and @e entries keeps them in a
+ * dense array in insertion order.  The table @e slots has the index of
+ * the entry (plus one, zero meaning empty) for every position of the
+ * perfect hash function, that is selected by the displacement found
+ * for the bucket of the word in @e disp.
+ */
+typedef struct {
+    lexentry_t *entries;    /**< Dense array of words */
+    size_t len;             /**< Number of words */
+    size_t cap;             /**< Allocated number of words */
+
+    char *pool;             /**< Strings of all words, one after another */
+    size_t pool_len;        /**< Used bytes of the pool */
+    size_t pool_cap;        /**< Allocated bytes of the pool */
+
+    uint32_t *disp;         /**< Displacement for every bucket */
+    size_t nbuckets;        /**< Number of buckets */
+    uint32_t *slots;        /**< Perfect hash table (entry index + 1) */
+    size_t nslots;          /**< Size of the table (power of two) */
+    uint32_t seed;          /**< Seed of the hash function */
+} lexicon_t;
+
+
+/* Public interface */
+/**
+ * @brief Creates an empty lexicon
+ *
+ * @return Pointer to the newly created lexicon, or @c NULL otherwise
+ */
+lexicon_t *lexicon_init(void);
+
+/**
+ * @brief Frees allocated memory
+ *
+ * @param lexicon Lexicon to deallocate
+ */
+void lexicon_destroy(lexicon_t *lexicon);
+
+/**
+ * @brief Adds a word to the lexicon
+ *
+ * @param lexicon Lexicon where to add the word
+ * @param word    Word to add
+ * @param lex     Lexeme type of the word
+ *
+ * @return @c true if the word is added, or @c false otherwise
+ *
+ * @note The word won't be found until @e lexicon_build is called again
+ *
+ * @note If the word was already added, the first one prevails
+ */
+bool lexicon_add(lexicon_t *lexicon, const char *word, lexeme_t lex);
+
+/**
+ * @brief Adds the words of a text lexicon
+ *
+ * Every line is the name of a category (@c verb, @c adverb,
+ * @c article, @c adjective, @c number, @c noun, @c preposition,
+ * @c pronoun or @c conjunction) followed by its words, separated by
+ * blanks.  Empty lines and lines starting with '#' are ignored.
+ *
+ * @param lexicon Lexicon where to add the words
+ * @param text    Text lexicon (not necessarily null-terminated)
+ * @param len     Length of the text
+ *
+ * @return Returns 0 if every word is added, or otherwise the number of
+ *         the first line with an unknown category or a word that can't
+ *         be added
+ *
+ * @note As with @e lexicon_add, @e lexicon_build has to be called after
+ */
+size_t lexicon_read(lexicon_t *lexicon, const char *text, size_t len);
+
+/**
+ * @brief Removes repeated words and computes the perfect hash table for
+ *        all the words in the lexicon
+ *
+ * @param lexicon Lexicon to build
+ *
+ * @return @c true if the table is built, or @c false otherwise
+ */
+bool lexicon_build(lexicon_t *lexicon);
+
+/**
+ * @brief Looks up a word in the lexicon
+ *
+ * @param lexicon Lexicon where to look up
+ * @param word    Word to look up (not necessarily null-terminated)
+ * @param len     Length of the word
+ *
+ * @return Pointer to the entry of the word, or @c NULL if not found
+ *
+ * @pre The lexicon has been built with @e lexicon_build
+ */
+const lexentry_t *lexicon_find(const lexicon_t *lexicon,
+                               const char *word, size_t len);
+
+/**
+ * @brief Returns the lexeme type of a word
+ *
+ * @param lexicon Lexicon where to look up
+ * @param word    Word to look up (not necessarily null-terminated)
+ * @param len     Length of the word
+ *
+ * @return Type of the lexeme, or @c LEX_UNK if the word is not known
+ *
+ * @see lexicon_find
+ */
+lexeme_t lexicon_type(const lexicon_t *lexicon, const char *word, size_t len);
+
+/**
+ * @brief Macro that evaluates to the number of words in the lexicon
+ */
+#define lexicon_len(l)  (l->len)
+
+/**
+ * @brief Macro that evaluates to the string (not null-terminated) of an
+ *        entry of the lexicon
+ */
+#define lexicon_word(l, e)  (l->pool + (e)->off)
+
+
+#endif /* LEXICON_H */
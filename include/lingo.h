@@ -40,13 +40,14 @@
  * state value.
  */
 typedef struct {
+    char *text;         /**< Memory of the three strings */
     char *desc;         /**< Object description */
     char *kname;        /**< Object known name */
     char *uname;        /**< Object unknown name */
 
-    wset_t *nouns;      /**< List of nouns to refer this object */
-    wset_t *adjs;       /**< List of (static) adjectives for this object */
-    wset_t *pronouns;   /**< List of pronouns related to this object */
+    wset_t nouns;       /**< List of nouns to refer this object */
+    wset_t adjs;        /**< List of (static) adjectives for this object */
+    wset_t pronouns;    /**< List of pronouns related to this object */
 
     bool direct;        /**< Is this object usually indirect or direct */
 } lingo_t;
@@ -67,11 +68,37 @@ typedef struct {
 lingo_t *lingo_init(const char *kname, const char *uname,
                     const char *desc, bool direct);
 
+/**
+ * @brief Initializes a lingo structure already allocated, as
+ *        @e lingo_init does
+ *
+ * @param lingo  Lingo structure to initialize
+ * @param kname  Known name
+ * @param uname  Unknown name
+ * @param desc   Description of the object
+ * @param direct Is usually a direct object, or indirect?
+ *
+ * @return @c true on success, or @c false if it can't allocate memory
+ *
+ * @note The three strings are copied into a single block of memory
+ */
+bool lingo_init_at(lingo_t *lingo, const char *kname, const char *uname,
+                   const char *desc, bool direct);
+
+/**
+ * @brief Frees the memory used by a lingo structure, but not the
+ *        structure itself
+ *
+ * @param lingo Lingo structure initialized with @e lingo_init_at
+ */
+void lingo_destroy_at(lingo_t *lingo);
+
 /**
  * @brief Frees allocted memory
  *
  * @param lingo        Lingo structure to free
- * @param destroy_sets If @c true, destroy also the word sets
+ * @param destroy_sets Unused, as the word sets are part of the lingo
+ *                     structure and they are always destroyed
  */
 void lingo_destroy(lingo_t *lingo, bool destroy_sets);
 
@@ -21,7 +21,9 @@
  *    * _Simple sentence_.  A sentence that can be parse as one unit
  *
  *    * _Compound sentence_.  A sentence that has to be separated to
- *                            parse each unit individually.
+ *                            parse each unit individually.  The units
+ *                            are separated by conjunctions ("and",
+ *                            "then").
  *
  * @code
  * int main(void)
@@ -37,33 +39,120 @@
 #define PARSER_H
 
 #define DELIMITERS " .,;:!-'\"(){}[]<>" /**< Characters to ignore on parsing */
-#define SEPARATOR  "and"
 
 /* Local includes */
+#include <arena.h>
 #include <cmd.h>
+#include <lexicon.h>
+#include <printer.h>
 
 
 /**
- * @brief lexeme_t
+ * @typedef parser_cmd_cb_t
  *
- * @brief Types of lexemes
+ * @brief Function told of every command found by @e parse_compound
+ *
+ * The arguments are the command, what parsing it returned (0 if it was
+ * understood, or 1 otherwise), and the user data.
  */
-typedef enum { LEX_END=-1,  /**< End of sentence, could be an error */
-               LEX_EMPTY=0, /**< Empty string */
-               LEX_ADJ,     /**< Adjective */
-               LEX_ADVERB,  /**< Verb */
-               LEX_ART,     /**< Article */
-               LEX_CONJ,    /**< Conjunction */
-               LEX_NOUN,    /**< Noun */
-               LEX_NUM,     /**< Number */
-               LEX_PREP,    /**< Preposition */
-               LEX_PRONOUN, /**< Pronoun */
-               LEX_VERB,    /**< Verb */
-               LEX_UNK=99,  /**< Extra / Unknown lexeme */
-} lexeme_t;
+typedef void (*parser_cmd_cb_t)(const cmdv_t *cmd, int ret_val, void *data);
 
 
 /* Public interface */
+/**
+ * @brief Builds the lexicon used by the parser
+ *
+ * @return Returns 0 if the lexicon is ready, or 1 if it can't be built
+ *
+ * @note It's called on demand by @e lexeme_type, but calling it first
+ *       keeps the cost of building the lexicon out of the first command
+ *
+ * @note Once initialized, the parser only reads the lexicon, so it can
+ *       be used from several threads at the same time.  It has to be
+ *       initialized before starting them, though
+ *
+ * @note It must also be called, or @e parser_load, before interning
+ *       any word (naming items included), since the atoms are bound
+ *       to the lexicon
+ */
+int parser_init(void);
+
+/**
+ * @brief Uses the lexicon stored in a file instead of the built-in one
+ *
+ * @param path Path of the lexicon file
+ *
+ * @return Returns 0 if the lexicon is loaded, or 1 if it can't be read
+ *         or some atom has been given already
+ *
+ * @note It must be called before any word is interned, as it changes
+ *       the words of the atoms; after @e parser_destroy it can be
+ *       called again
+ *
+ * @see lexfile_load, atom_in_use
+ */
+int parser_load(const char *path);
+
+/**
+ * @brief Frees the memory allocated by @e parser_init or @e parser_load
+ */
+void parser_destroy(void);
+
+/**
+ * @brief Gets the lexicon used by the parser
+ *
+ * @return Lexicon, or @c NULL if it's not built or loaded yet
+ *
+ * @see parser_init, parser_load
+ */
+const lexicon_t *parser_lexicon(void);
+
+/**
+ * @brief Sets the printer where the messages of the parser go
+ *
+ * @param printer Printer, or @c NULL to print to @e stdout
+ *
+ * @note The printer is set for the calling thread only
+ */
+void parser_set_printer(printer_t *printer);
+
+/**
+ * @brief Sets the function told of every command parsed
+ *
+ * @param cb   Function, or @c NULL to stop telling it
+ * @param data Data passed to the function
+ *
+ * @note The function is set for the calling thread only
+ */
+void parser_set_observer(parser_cmd_cb_t cb, void *data);
+
+/**
+ * @brief Gets the memory of the current turn, where everything that is
+ *        needed only until the input line is handled is allocated
+ *
+ * @return Arena of the turn, or @c NULL if it can't allocate memory
+ *
+ * @note Every thread has its own arena
+ *
+ * @see parser_end_turn, parser_free_turn, turn_line
+ */
+arena_t *parser_turn(void);
+
+/**
+ * @brief Ends the turn, freeing at once everything allocated in it
+ *
+ * @see parser_turn
+ */
+void parser_end_turn(void);
+
+/**
+ * @brief Frees the memory of the turns of the calling thread
+ *
+ * @note Threads that handle turns have to call it before they end, as
+ *       @e parser_destroy only frees the memory of its own thread
+ */
+void parser_free_turn(void);
+
 /**
  * @brief Returns the type of a word checking with a "database"
  *
@@ -71,7 +160,7 @@ typedef enum { LEX_END=-1,  /**< End of sentence, could be an error */
  *
  * @return Type of lexeme
  *
- * @see lexeme_t
+ * @see lexeme_t, lexicon_type
  */
 lexeme_t lexeme_type(const char *word);
 
@@ -82,34 +171,75 @@ lexeme_t lexeme_type(const char *word);
  *
  * @return Returns 0 if no errors, or otherwise
  *
- * @see cmd_t
+ * @see cmdv_t
  */
-int parse_cmd(cmd_t *cmd);
+int parse_cmd(const cmdv_t *cmd);
 
 /**
  * @brief Parses a single sentence
  *
  * @param sentence Sentence to parse
  *
- * @return Returns 0 if transverses the whole sentence,
- *                 1 if can't allocate memory,
- *                 or otherwise
+ * @return Returns 0 if transverses the whole sentence, or otherwise
+ *
+ * @note No memory is allocated: the command is a view over the
+ *       sentence, so the sentence is not modified either
+ *
+ * @see cmdv_t
  */
 int parse_simple(char *sentence);
 
+/**
+ * @brief Splits a compound sentence in commands
+ *
+ * Every conjunction found in the sentence closes a command and begins
+ * the next one.  Words are matched whole, so a conjunction inside
+ * another word (e.g., "wand") is not a separator.
+ *
+ * @param line Sentence to split (not necessarily null-terminated)
+ * @param len  Length of the sentence
+ * @param list Where to store the commands found
+ *
+ * @return Number of commands found
+ *
+ * @note The sentence is walked once and no memory is allocated; the
+ *       commands are views over the sentence
+ *
+ * @see cmdlist_t
+ */
+size_t parse_line(const char *line, size_t len, cmdlist_t *list);
+
 /**
  * @brief Parse several sentences connected by a copulative lexeme
  *
  * @param sentence Compound sentence to parse
  *
  * @return Returns 0 if parses all sentences successfully,
- *                -1 if the sentence is empty, or otherwise
+ *                -1 if the sentence is empty, or otherwise the number
+ *                of sentences that couldn't be understood
+ *
+ * @note Only the first @c CMD_LIST_MAX sentences are parsed; if there
+ *       are more, the rest count as one more that couldn't be
+ *       understood
  *
- * @todo Refactor: too many calls to @e str_trim, too many iterations
- *                 and too many pointers that may be unneeded
+ * @see parse_line, parse_normalized
  */
 int parse_compound(char *sentence);
 
+/**
+ * @brief Like @e parse_compound, for a sentence already normalized
+ *
+ * @param sentence Sentence trimmed and in lowercase, as
+ *                 @e str_normalize_l leaves it (not necessarily
+ *                 null-terminated)
+ * @param len      Length of the sentence
+ *
+ * @return Same as @e parse_compound
+ *
+ * @see str_normalize
+ */
+int parse_normalized(const char *sentence, size_t len);
+
 /**
  * @brief An alias for @e parse_compound
  */
@@ -15,51 +15,230 @@
  * @file printer.h
  *
  * @brief Printing routines declaration
+ *
+ * Everything printed is collected in a buffer, and it's delivered to
+ * the sink of the printer all at once when the printer is flushed, or
+ * when the buffer gets to @c PRINTER_FLUSH_AT bytes, so the output of
+ * a whole turn usually takes a single @e write.
+ *
+ * @code
+ * printer_t *out = printer_init_fd(STDOUT_FILENO);
+ * ps(out, "You see a key.");
+ * pf(out, door, open);     // "It's open." or "It's closed."
+ * printer_flush(out);      // before showing the prompt
+ * @endcode
  */
 
 #ifndef PRINTER_H
 #define PRINTER_H
 
+/* System includes */
+#include <stdarg.h>     /* va_list */
+#include <stdbool.h>    /* bool */
+#include <stddef.h>     /* size_t */
+
+/* Local includes */
+#include <flag.h>
+#include <qltys.h>
+
+#define PRINTER_FLUSH_AT  (4096)    /**< Bytes that force a flush */
+
+
+/**
+ * @typedef printer_sink_t
+ *
+ * @brief Where the output of a printer goes
+ */
+typedef enum {
+    PRINTER_FD,     /**< File descriptor */
+    PRINTER_MEM,    /**< Nowhere, it's kept in the buffer */
+    PRINTER_CB,     /**< Function */
+} printer_sink_t;
+
+
+/**
+ * @typedef printer_cb_t
+ *
+ * @brief Function that takes the output of a printer
+ *
+ * The arguments are the output, its length, and the user data.  It
+ * returns a negative number on error.
+ */
+typedef int (*printer_cb_t)(const char *s, size_t len, void *data);
+
 
 /**
  * @typedef printer_t
  *
- * @brief Printer structure, with a pointer to a function to print
+ * @brief Printer structure, with a buffer and where to send it
  *
  * Why bother with this?  In the future will be easier to use made
  * functions to format the output strings, using colors or identifying
  * keywords on the string, and point to that here.
  */
 typedef struct {
-//    const char *s;              /**< String to print */
-    int (*print)(const char *); /**< Function to print with */
+    char *buf;              /**< Output not delivered yet */
+    size_t len;             /**< Length of the output */
+    size_t cap;             /**< Allocated length of the buffer */
+    printer_sink_t sink;    /**< Where the output goes */
+    int fd;                 /**< File descriptor, for @c PRINTER_FD */
+    printer_cb_t cb;        /**< Function, for @c PRINTER_CB */
+    void *data;             /**< User data, for @c PRINTER_CB */
+    int (*print)(const char *); /**< Function of @e printer_init */
 } printer_t;
 
 
 /* Public interface */
 /**
- * @brief Initializes printer "object"
+ * @brief Initializes printer "object" that sends its output to a
+ *        function taking a null-terminated string, such as @e puts
+ *
+ * @param print Function to print with, called once per flush
+ *
+ * @return Pointer to the printer, or @c NULL otherwise
  */
 printer_t *printer_init(int (*print)(const char *));
 
 /**
- * @brief Frees allocated memory
+ * @brief Initializes a printer that writes to a file descriptor
+ *
+ * @param fd File descriptor
+ *
+ * @return Pointer to the printer, or @c NULL otherwise
+ */
+printer_t *printer_init_fd(int fd);
+
+/**
+ * @brief Initializes a printer that keeps its output in memory
+ *
+ * @return Pointer to the printer, or @c NULL otherwise
+ *
+ * @see printer_data, printer_clear
+ */
+printer_t *printer_init_mem(void);
+
+/**
+ * @brief Initializes a printer that sends its output to a function
+ *
+ * @param cb   Function called once per flush
+ * @param data Data passed to the function
+ *
+ * @return Pointer to the printer, or @c NULL otherwise
+ */
+printer_t *printer_init_cb(printer_cb_t cb, void *data);
+
+/**
+ * @brief Frees allocated memory, flushing the printer before
  *
  * @param printer Printer "object" to deallocate
  */
 void printer_destroy(printer_t *printer);
 
 /**
- * @brief Prints a flag string depending on the value of its state
+ * @brief Adds text to the output, as it is
  *
  * @param printer Printer structure
+ * @param s       Text (not necessarily null-terminated)
+ * @param len     Length of the text
+ *
+ * @return Returns the number of bytes added, or a negative number if
+ *         it can't allocate memory or the output can't be delivered
+ */
+int printer_write(printer_t *printer, const char *s, size_t len);
+
+/**
+ * @brief Adds a line to the output, as @e puts does
+ *
+ * @param printer Printer structure
+ * @param s       Null-terminated string
+ *
+ * @return Returns the number of bytes added, or a negative number on
+ *         error
+ */
+int printer_puts(printer_t *printer, const char *s);
+
+/**
+ * @brief Adds formatted text to the output, as @e printf does
+ *
+ * @param printer Printer structure
+ * @param fmt     Format string
+ *
+ * @return Returns the number of bytes added, or a negative number on
+ *         error
+ */
+int printer_printf(printer_t *printer, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Adds formatted text to the output, as @e vprintf does
+ *
+ * @param printer Printer structure
+ * @param fmt     Format string
+ * @param args    Arguments of the format
+ *
+ * @return Returns the number of bytes added, or a negative number on
+ *         error
+ */
+int printer_vprintf(printer_t *printer, const char *fmt, va_list args);
+
+/**
+ * @brief Delivers the output to the sink of the printer
+ *
+ * @param printer Printer structure
+ *
+ * @return Returns 0 on success, or a negative number if the output
+ *         can't be delivered
+ *
+ * @note A printer that keeps its output in memory is never flushed
+ */
+int printer_flush(printer_t *printer);
+
+/**
+ * @brief Gets the output kept by a printer
+ *
+ * @param printer Printer structure
+ * @param len     Where to save the length of the output, or @c NULL
+ *
+ * @return Output, null-terminated
+ */
+const char *printer_data(const printer_t *printer, size_t *len);
+
+/**
+ * @brief Discards the output kept by a printer
+ *
+ * @param printer Printer structure
+ */
+void printer_clear(printer_t *printer);
+
+/**
+ * @brief Prints a flag string for a state
+ *
+ * @param printer Printer structure
+ * @param flag    Flag to print
+ * @param state   State to print the string of
  *
  * @return Returns a non negative number on success, or 0 if there are
  *         no valid strings to print
  *
  * @see flag_t
  */
-int printer_flag(printer_t *printer, flag_t *flag);
+int printer_flag(printer_t *printer, const flag_t *flag, bool state);
+
+/**
+ * @brief Prints a flag string depending on the state of the flag in a
+ *        set of qualities
+ *
+ * @param printer Printer structure
+ * @param qltys   Qualities set with the state of the flag
+ * @param flag    Flag to print
+ *
+ * @return Returns a non negative number on success, or 0 if there are
+ *         no valid strings to print or the flag is not in the set
+ *
+ * @see qltys_state
+ */
+int printer_qlty(printer_t *printer, const qltys_t *qltys,
+                 const flag_t *flag);
 
 /**
  * @brief Macro that evaluates to the initialization of the printer
@@ -70,15 +249,15 @@ int printer_flag(printer_t *printer, flag_t *flag);
 /**
  * @brief Macro that evaluates to the printing of a string (print string)
  */
-#define ps(printer, string)  (printer->print(string))
+#define ps(printer, string)  printer_puts(printer, string)
 
 /**
- * @brief Macro that evaluates to the printing of a flag (print flag)
+ * @brief Macro that evaluates to the printing of a flag with its state
+ *        in an item (print flag)
  *
- * @see flag_t
+ * @see printer_qlty
  */
-#define pf(printer, flag)  printer_flag(printer, flag)
+#define pf(printer, item, flag)  printer_qlty(printer, (item)->qltys, flag)
 
 
 #endif /* PRINTER_H */
-
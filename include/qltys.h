@@ -14,8 +14,21 @@
 /**
  * @file qltys.h
  *
- * @brief Array of different flags to be used each one as a dynamic
+ * @brief Set of different flags to be used each one as a dynamic
  *       adjective
+ *
+ * The qualities are two bitmaps indexed by the identifiers of the
+ * flags: one tells which flags are in the set, and the other one the
+ * state of every flag in it.  Adding, removing, toggling or checking a
+ * flag is a single bit operation, and comparing many flags at once is
+ * a few word operations.
+ *
+ * @code
+ * flag_t *open = flag_init(false, "It's open.", "It's closed.");
+ * qltys_add(door, open);           // closed, the initial state
+ * qltys_toggle_flag(door, open);
+ * qltys_state(door, open);         // true
+ * @endcode
  */
 
 #ifndef QLTYS_H
@@ -23,99 +36,126 @@
 
 /* System includes */
 #include <stdbool.h>    /* bool */
+#include <stddef.h>     /* size_t */
+#include <stdint.h>     /* uint64_t */
 
 /* Local includes */
 #include <flag.h>
 
+#define QLTYS_WORDS  ((FLAG_MAX + 63) / 64) /**< Words of a bitmap */
+
 
 /**
  * @typedef qltys_t
  *
- * @brief In short words, array of flags
+ * @brief In short words, set of flags, each one with its own state
  */
 typedef struct {
-    flag_t **flags;
-    size_t len;
+    uint64_t has[QLTYS_WORDS];      /**< Flags in the set */
+    uint64_t state[QLTYS_WORDS];    /**< State of the flags in the set */
 } qltys_t;
 
 
 /* Public interface */
 /**
- * @brief Allocates memory for qualities array
+ * @brief Allocates memory for an empty set of qualities
  *
- * @return Pointer to the newly created qualities array
+ * @return Pointer to the newly created qualities set
  */
 qltys_t *qltys_init(void);
 
+/**
+ * @brief Empties a qualities set already allocated
+ *
+ * @param qltys Qualities set to initialize
+ */
+void qltys_init_at(qltys_t *qltys);
+
 /**
  * @brief Frees allocated memory
  *
- * @param qltys         Qualities array to free
- * @param destroy_flags If @c true, frees also the memory of used flags
+ * @param qltys Qualities set to free
+ *
+ * @note The flags are shared by every set of qualities, so they are
+ *       not destroyed with the set; that's up to who initialized them
  */
-void qltys_destroy(qltys_t *qltys, bool destroy_flags);
+void qltys_destroy(qltys_t *qltys);
 
 /**
- * @brief Check if a flag is contained in the qualities array
+ * @brief Check if a flag is contained in the qualities set
  *
- * @param qltys Qualities array to search in
+ * @param qltys Qualities set to search in
  * @param flag  Flag to search for
  *
- * @return @c true if the flag is on the array, or @c false otherwise
+ * @return @c true if the flag is on the set, or @c false otherwise
  */
-bool qltys_has_flag(qltys_t *qltys, flag_t *flag);
+bool qltys_has_flag(const qltys_t *qltys, const flag_t *flag);
 
 /**
- * @brief Searches for and toggles a flag in the qualities array
+ * @brief Gets the state of a flag in the qualities set
  *
- * @param qltys Qualities array
+ * @param qltys Qualities set
+ * @param flag  Flag to check
+ *
+ * @return @c true if the flag is on the set and its state is @c true,
+ *         or @c false otherwise
+ */
+bool qltys_state(const qltys_t *qltys, const flag_t *flag);
+
+/**
+ * @brief Toggles the state of a flag in the qualities set
+ *
+ * @param qltys Qualities set
  * @param flag  Flag to toggle
  *
  * @return @c true if the flag was succesfully toggled, or @c false
- *         otherwise
- *
- * @see flag_toggle
+ *         if it's not in the set
  */
-bool qltys_toggle_flag(qltys_t *qltys, flag_t *flag);
+bool qltys_toggle_flag(qltys_t *qltys, const flag_t *flag);
 
 /**
- * @brief Adds a new flag to the qualities array
+ * @brief Adds a new flag to the qualities set, with the initial state
+ *        of the flag
  *
- * @param qltys Qualities array to add the flag to
+ * @param qltys Qualities set to add the flag to
  * @param flag  Flag to add
  *
  * @return @c true if the flag is succesfully added, or @c false
  *         otherwise
  */
-bool qltys_add(qltys_t *qltys, flag_t *flag);
+bool qltys_add(qltys_t *qltys, const flag_t *flag);
 
 /**
- * @brief Removes a new flag from the qualities array
+ * @brief Removes a flag from the qualities set
  *
- * @param qltys Qualities array to remove the flag from
+ * @param qltys Qualities set to remove the flag from
  * @param flag  Flag to remove
  *
  * @return @c true if the flag is succesfully removed, or @c false
  *         otherwise
  */
-bool qltys_rem(qltys_t *qltys, flag_t *flag);
+bool qltys_rem(qltys_t *qltys, const flag_t *flag);
 
 /**
- * @brief Macro that evaluates to the deallocation of all the qualities,
- *        without deallocating any flag that contains
+ * @brief Checks if a qualities set has every flag of a pattern, and
+ *        with the same state
+ *
+ * @param qltys   Qualities set to check
+ * @param pattern Flags to look for, with the states they must have
  *
- * @see qltys_destroy
+ * @return @c true if every flag of @e pattern is in @e qltys with the
+ *         same state, or @c false otherwise
  */
-#define qltys_destroy_soft(q)  qltys_destroy(q, false)
+bool qltys_match(const qltys_t *qltys, const qltys_t *pattern);
 
 /**
- * @brief Macro that evaluates to the deallocation of all the qualities,
- *        and also every flag that contains
+ * @brief Counts the flags in the qualities set
  *
- * @see qltys_destroy
+ * @param qltys Qualities set
+ *
+ * @return Number of flags in the set
  */
-#define qltys_destroy_hard(q)  qltys_destroy(q, true)
+size_t qltys_count(const qltys_t *qltys);
 
 
 #endif /* QLTYS_H */
-
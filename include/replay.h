@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file replay.h
+ *
+ * @brief Plays again every line of a transcript
+ *
+ * Every line of the file is a turn of a single player, handled in
+ * order as if it were typed, but without prompts.  The answers are not
+ * shown, only counted; the words of every command found, and whether
+ * it was understood, are summarized in a digest, so two runs can be
+ * compared at a glance, e.g., before and after a change in the engine.
+ * The answers are left out of the digest, so it's the same for every
+ * build of the same engine.
+ *
+ * @code
+ * replay_stats_t stats;
+ * if (replay_file("transcript.txt", &stats) == 0) {
+ *     printf("%016" PRIx64 "\n", stats.digest);
+ * }
+ * @endcode
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+/* System includes */
+#include <stddef.h>     /* size_t */
+#include <stdint.h>     /* uint64_t */
+
+#define REPLAY_DIGEST_INIT  (0xcbf29ce484222325ULL) /**< Nothing hashed */
+
+
+/**
+ * @typedef replay_stats_t
+ *
+ * @brief What happened when replaying a transcript
+ */
+typedef struct {
+    size_t lines;       /**< Lines handled */
+    size_t bytes;       /**< Bytes of the answers */
+    uint64_t digest;    /**< Hash of the commands (FNV-1a) */
+    uint64_t ns;        /**< Time taken, in nanoseconds */
+} replay_stats_t;
+
+
+/* Public interface */
+/**
+ * @brief Handles every line of a file, as the turns of a player
+ *
+ * The file is mapped in memory and walked once; lines have no length
+ * limit, and the replay ends at the last line or when the player
+ * quits.
+ *
+ * @param path  Path of the transcript
+ * @param stats Where to store what happened
+ *
+ * @return Returns 0 if every line is handled,
+ *                 1 if the parser or the printer can't be initialized,
+ *                 2 if the file can't be read
+ *
+ * @see turn_line
+ */
+int replay_file(const char *path, replay_stats_t *stats);
+
+
+#endif /* REPLAY_H */
+
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file server.h
+ *
+ * @brief Serves many players at once on a Unix domain socket
+ *
+ * Every connection is a session, with its own line of input, the state
+ * of its commands and a printer where its answers are collected.  The
+ * sessions are shared out among a few threads, the shards, each one
+ * waiting for its own sessions with @e epoll, and handling the lines as
+ * they arrive, so a session costs only what it holds: about
+ * @c SERVER_LINE_MAX bytes plus the answers not sent yet.  A shard with
+ * nothing to do takes ready sessions from the others.
+ *
+ * @code
+ * $ bin/main --server /tmp/textad.sock &
+ * $ socat - UNIX-CONNECT:/tmp/textad.sock
+ * @endcode
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#define SERVER_LINE_MAX  (1024)         /**< Longest line of a session */
+#define SERVER_OUT_MAX   (64 * 1024)    /**< Answers held for a session */
+#define SERVER_THREADS_MAX  (1024)      /**< Most shards of a server */
+#define SERVER_BACKLOG   (128)          /**< Connections waiting */
+#define SERVER_EVENTS    (64)           /**< Events taken at once */
+
+
+/* Public interface */
+/**
+ * @brief Serves sessions on a Unix domain socket until stopped
+ *
+ * @param path     Path of the socket, replaced only if it's a socket
+ * @param nthreads Number of shards, up to @c SERVER_THREADS_MAX, or 0
+ *                 to use one per core
+ *
+ * @return Returns 0 if stopped by @e server_stop, or 1 if the socket
+ *         can't be set up
+ *
+ * @note The calling thread is one of the shards.  The parser has to be
+ *       initialized before, as the shards only read the lexicon
+ *
+ * @note Lines longer than @c SERVER_LINE_MAX are ignored, and sessions
+ *       that don't read their answers, once these get to
+ *       @c SERVER_OUT_MAX bytes, are closed
+ */
+int server_run(const char *path, unsigned nthreads);
+
+/**
+ * @brief Asks the server to stop, closing every session
+ *
+ * @note It can be called from a signal handler
+ */
+void server_stop(void);
+
+
+#endif /* SERVER_H */
+
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file slab.h
+ *
+ * @brief Allocator of objects of a fixed size
+ *
+ * The objects are taken from big blocks of memory, many objects each,
+ * and the freed objects are kept in a list to be given again, so
+ * creating thousands of objects takes only a few allocations, and
+ * objects created one after another are next to each other in memory.
+ *
+ * @code
+ * static slab_t slab = SLAB_INIT(sizeof(item_t), 256);
+ *
+ * item_t *item = slab_alloc(&slab);
+ * slab_free(&slab, item);
+ * @endcode
+ */
+
+#ifndef SLAB_H
+#define SLAB_H
+
+/* System includes */
+#include <pthread.h>    /* pthread_mutex_t */
+#include <stddef.h>     /* size_t */
+
+
+/**
+ * @typedef slab_t
+ *
+ * @brief Blocks of objects and list of the free ones
+ */
+typedef struct {
+    size_t size;            /**< Size of an object */
+    size_t per_block;       /**< Objects in every block */
+    void *blocks;           /**< List of blocks */
+    void *free;             /**< List of free objects */
+    size_t used;            /**< Objects given in the last block */
+    pthread_mutex_t lock;   /**< Lock of the lists */
+} slab_t;
+
+
+/**
+ * @brief Static initializer of a slab
+ *
+ * @param s Size of an object
+ * @param n Objects in every block
+ */
+#define SLAB_INIT(s, n)  \
+    { (s), (n), NULL, NULL, (n), PTHREAD_MUTEX_INITIALIZER }
+
+
+/* Public interface */
+/**
+ * @brief Takes a new object from a slab
+ *
+ * @param slab Slab to take the object from
+ *
+ * @return Pointer to an object, uninitialized, or @c NULL if it can't
+ *         allocate memory
+ */
+void *slab_alloc(slab_t *slab);
+
+/**
+ * @brief Gives back an object to a slab
+ *
+ * @param slab Slab where the object was taken from
+ * @param obj  Object to give back, or @c NULL
+ */
+void slab_free(slab_t *slab, void *obj);
+
+/**
+ * @brief Frees every block of a slab
+ *
+ * @param slab Slab to empty
+ *
+ * @warning Every object taken from the slab is no longer valid
+ */
+void slab_destroy(slab_t *slab);
+
+
+#endif /* SLAB_H */
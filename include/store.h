@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file store.h
+ *
+ * @brief Central store of every item, indexed by identifier
+ *
+ * The fields of the items used on every pass over the world (weight,
+ * qualities and inventory where the item is) are kept in parallel
+ * arrays indexed by the item identifier, away from the strings of the
+ * items, so finding an item by its identifier takes constant time,
+ * and going through every item reads only the memory needed.
+ *
+ * The arrays are split in pages of fixed size that never move, so the
+ * qualities of an item, which are in the store, can be reached from
+ * the item too.
+ *
+ * @code
+ * item_t *key = store_get(id);
+ * store_owner(id);         // inventory where the key is
+ * @endcode
+ *
+ * @note Every item is added to the store by @e item_init, and removed
+ *       by @e item_destroy
+ *
+ * @note The identifiers of the items removed are given to the items
+ *       added later, so up to <tt>STORE_PAGE * STORE_MAX_PAGES - 1</tt>
+ *       items can be alive at once
+ *
+ * @note Items can be looked up from several threads while others add
+ *       or remove items, but changing an item (its weight, qualities or
+ *       inventory) has to be done by one thread at a time, and not
+ *       while others read that same item
+ */
+
+#ifndef STORE_H
+#define STORE_H
+
+/* System includes */
+#include <stdbool.h>    /* bool */
+#include <stddef.h>     /* size_t */
+#include <stdint.h>     /* uint32_t */
+
+/* Local includes */
+#include <inventory.h>
+#include <item.h>
+#include <qltys.h>
+
+#define STORE_PAGE       (1024) /**< Items in a page */
+#define STORE_MAX_PAGES  (4096) /**< Maximum number of pages */
+
+
+/* Public interface */
+/**
+ * @brief Adds an item to the store, with no qualities and out of any
+ *        inventory, gives it an identifier, and points the qualities of
+ *        the item to the store
+ *
+ * @param item Item to add, with its weight set
+ *
+ * @return @c true on success, or @c false if the store is full or it
+ *         can't allocate memory
+ *
+ * @note The identifier of an item removed before is given first
+ */
+bool store_add(item_t *item);
+
+/**
+ * @brief Removes an item from the store
+ *
+ * @param item Item to remove
+ *
+ * @note Its identifier is given to the next item added
+ */
+void store_rem(item_t *item);
+
+/**
+ * @brief Gets an item by its identifier
+ *
+ * @param id Item identifier
+ *
+ * @return Pointer to the item, or @c NULL if there's no such item
+ */
+item_t *store_get(uint32_t id);
+
+/**
+ * @brief Gets the inventory where an item is
+ *
+ * @param id Item identifier
+ *
+ * @return Last inventory the item was added to, or @c NULL if it's not
+ *         in any inventory
+ */
+inv_t *store_owner(uint32_t id);
+
+/**
+ * @brief Sets the inventory where an item is
+ *
+ * @param id  Item identifier
+ * @param inv Inventory, or @c NULL if it's not in any inventory
+ *
+ * @note Called by the inventory routines
+ */
+void store_set_owner(uint32_t id, inv_t *inv);
+
+/**
+ * @brief Gets the weight of an item
+ *
+ * @param id Item identifier
+ *
+ * @return Item weight, or 0 if there's no such item
+ */
+weight_t store_weight(uint32_t id);
+
+/**
+ * @brief Sets the weight of an item, and updates the weight of the
+ *        inventory where the item is
+ *
+ * @param id     Item identifier
+ * @param weight New weight
+ *
+ * @return @c true on success, or @c false if there's no such item
+ */
+bool store_set_weight(uint32_t id, weight_t weight);
+
+/**
+ * @brief Sums the weight of every item in an inventory going through
+ *        the store, instead of the inventory
+ *
+ * @param inv Inventory
+ *
+ * @return Sum of the weights of the items whose owner is @e inv
+ */
+weight_t store_eval_weight(const inv_t *inv);
+
+/**
+ * @brief Finds every item with the flags of a pattern
+ *
+ * @param pattern Flags that the items must have, with their states
+ * @param inv     Inventory where the items must be, or @c NULL for any
+ * @param items   Array where to save the items found, or @c NULL
+ * @param max     Length of the array
+ *
+ * @return Number of items found, that can be greater than @e max, as
+ *         only the first @e max items are saved
+ *
+ * @see qltys_match
+ */
+size_t store_match(const qltys_t *pattern, const inv_t *inv,
+                   item_t **items, size_t max);
+
+/**
+ * @brief Frees the memory of the store
+ *
+ * @warning The qualities of every item are in the store, so it must be
+ *          called only after destroying every item
+ */
+void store_destroy(void);
+
+
+#endif /* STORE_H */
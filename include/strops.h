@@ -21,6 +21,7 @@
 #define STROPS_H
 
 #include <stdbool.h> /* bool */
+#include <stdint.h>  /* uint8_t */
 #include <stdlib.h>  /* malloc */
 #include <string.h>  /* strcmp, strlen */
 
@@ -31,6 +32,58 @@
 typedef enum { LOWERCASE, UPPERCASE } lettercase_t;
 
 
+/**
+ * @typedef span_t
+ *
+ * @brief Chunk of a string, not necessarily null-terminated
+ */
+typedef struct {
+    const char *s;  /**< First character of the chunk */
+    size_t len;     /**< Length of the chunk */
+} span_t;
+
+
+/**
+ * @typedef charset_t
+ *
+ * @brief Set of characters, made to find them fast in a string
+ *
+ * Besides a table with a bit for every byte, the set keeps two tables
+ * indexed by the low and the high nibble of a byte, such that the byte
+ * is in the set if both entries share some bit.  That allows to check
+ * 16 or 32 bytes at a time with byte shuffles, when there are no more
+ * than 8 different groups of characters by high nibble, which is
+ * usually the case; otherwise, only the bit table is used.
+ */
+typedef struct {
+    uint8_t bits[32];   /**< Bit for every byte in the set */
+    uint8_t lo[16];     /**< Groups of every low nibble */
+    uint8_t hi[16];     /**< Groups of every high nibble */
+    bool vector;        /**< The nibble tables can be used */
+} charset_t;
+
+
+/**
+ * @typedef str_iter_t
+ *
+ * @brief Iterator over the chunks of a string between delimiters
+ *
+ * @code
+ * str_iter_t it = str_iter(s, strlen(s), &delims);
+ * span_t word;
+ *
+ * while (str_iter_next(&it, &word)) {
+ *     printf("%.*s\n", (int) word.len, word.s);
+ * }
+ * @endcode
+ */
+typedef struct {
+    const char *cursor;         /**< Next character to read */
+    const char *end;            /**< End of the string */
+    const charset_t *delims;    /**< Delimiters */
+} str_iter_t;
+
+
 /* Public interface */
 /**
  * @brief Check if a string is in an array of strings
@@ -71,9 +124,75 @@ void str_transform_case(char *s, int (*f)(int));
  * @param s          String to normalize
  * @param lettercase Uppercase or lowercase as normalization
  *
- * @see str_trim, str_tolower, lettercase_t
+ * @return Length of the normalized string
+ *
+ * @see str_normalize_span, lettercase_t
+ */
+size_t str_normalize(char **s, lettercase_t lettercase);
+
+/**
+ * @brief Normalize a chunk of a string in place, without moving it
+ *
+ * Every character is transformed to the letter case, and the bounds
+ * of the trimmed string are found in the same pass.  ASCII text is
+ * processed in blocks with SIMD instructions when available; any other
+ * byte is transformed with @e tolower or @e toupper.
+ *
+ * @param s          Chunk to normalize (not necessarily null-terminated)
+ * @param len        Length of the chunk
+ * @param lettercase Uppercase or lowercase as normalization
+ *
+ * @return Chunk of @e s without leading and trailing white spaces
+ *
+ * @see str_normalize
  */
-void str_normalize(char **s, lettercase_t lettercase);
+span_t str_normalize_span(char *s, size_t len, lettercase_t lettercase);
+
+/**
+ * @brief Initializes a set of characters
+ *
+ * @param set   Set to initialize
+ * @param chars Characters of the set (not necessarily null-terminated)
+ * @param len   Number of characters
+ */
+void charset_init(charset_t *set, const char *chars, size_t len);
+
+/**
+ * @brief Gets the length of the initial chunk of a string made only of
+ *        characters in a set, like @e strspn
+ *
+ * @param set Set of characters
+ * @param s   String (not necessarily null-terminated)
+ * @param len Length of the string
+ *
+ * @return Length of the chunk
+ */
+size_t str_span_in(const charset_t *set, const char *s, size_t len);
+
+/**
+ * @brief Gets the length of the initial chunk of a string made only of
+ *        characters not in a set, like @e strcspn
+ *
+ * @param set Set of characters
+ * @param s   String (not necessarily null-terminated)
+ * @param len Length of the string
+ *
+ * @return Length of the chunk
+ */
+size_t str_span_out(const charset_t *set, const char *s, size_t len);
+
+/**
+ * @brief Gets the next chunk of a string between delimiters
+ *
+ * @param it   Iterator
+ * @param span Where to leave the chunk
+ *
+ * @return @c true if there's a chunk, or @c false at the end of the
+ *         string
+ *
+ * @see str_iter_t
+ */
+bool str_iter_next(str_iter_t *it, span_t *span);
 
 /**
  * @brief String copying with safe boundaries
@@ -107,6 +226,20 @@ char *str_ncpy(char *dest, const char *src, size_t len);
  */
 char *str_alloc_cpy(const char *src);
 
+/**
+ * @brief Macro that evaluates to @c true if a character is in a set
+ */
+#define charset_has(set, c)  \
+    (((set)->bits[(uint8_t) (c) >> 3] >> ((uint8_t) (c) & 7)) & 1)
+
+/**
+ * @brief Macro that evaluates to an iterator over the chunks of a
+ *        string between delimiters
+ *
+ * @see str_iter_t
+ */
+#define str_iter(s, len, delims)  ((str_iter_t) { s, (s) + (len), delims })
+
 /**
  * @brief Macro that evaluates to @e str_transform using @e tolower
  *
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file tmpl.h
+ *
+ * @brief Message templates
+ *
+ * A message is parsed once into a list of segments, either literal
+ * text or a placeholder, and every time it's printed the segments are
+ * written straight into the buffer of a printer.  The placeholders are:
+ *
+ *   - @c {kname}: known name of the item
+ *   - @c {uname}: unknown name of the item, or its known name if it
+ *                 has none
+ *   - @c {desc}:  description of the item
+ *   - @c {qty}:   quantity
+ *   - @c {flag}:  text of the flag for its state in the item
+ *   - @c {action}, @c {mode}, @c {number}, @c {quality}, @c {dobj},
+ *     @c {iobj}: words of a command, as they were typed
+ *   - @c {unknown}: first word of a command not understood
+ *
+ * and @c {{ and @c }} are a literal brace.
+ *
+ * @code
+ * tmpl_t *took = tmpl_init("You take {qty} {kname}. {flag}");
+ * tmpl_args_t args = { key, 2, rusty };
+ * pt(out, took, &args);
+ * @endcode
+ */
+
+#ifndef TMPL_H
+#define TMPL_H
+
+/* System includes */
+#include <stddef.h>     /* size_t */
+
+/* Local includes */
+#include <cmd.h>
+#include <flag.h>
+#include <item.h>
+#include <printer.h>
+
+
+/**
+ * @typedef tmpl_seg_type_t
+ *
+ * @brief Kind of a segment of a template
+ */
+typedef enum {
+    TMPL_TEXT,      /**< Literal text */
+    TMPL_KNAME,     /**< Known name of the item */
+    TMPL_UNAME,     /**< Unknown name of the item */
+    TMPL_DESC,      /**< Description of the item */
+    TMPL_QTY,       /**< Quantity */
+    TMPL_FLAG,      /**< Text of the flag */
+    TMPL_ACTION,    /**< Action of the command */
+    TMPL_MODE,      /**< Mode of the command */
+    TMPL_NUMBER,    /**< Quantity of the command, as a word */
+    TMPL_QUALITY,   /**< Quality of the command */
+    TMPL_DOBJ,      /**< Direct object of the command */
+    TMPL_IOBJ,      /**< Indirect object of the command */
+    TMPL_UNKNOWN,   /**< Word of the command not understood */
+} tmpl_seg_type_t;
+
+
+/**
+ * @typedef tmpl_seg_t
+ *
+ * @brief Segment of a template
+ */
+typedef struct {
+    tmpl_seg_type_t type;   /**< Kind of segment */
+    const char *s;          /**< Text, for @c TMPL_TEXT */
+    size_t len;             /**< Length of the text */
+} tmpl_seg_t;
+
+
+/**
+ * @typedef tmpl_t
+ *
+ * @brief Parsed template
+ */
+typedef struct {
+    char *text;         /**< Literal text of every segment */
+    size_t len;         /**< Number of segments */
+    tmpl_seg_t segs[];  /**< Segments */
+} tmpl_t;
+
+
+/**
+ * @typedef tmpl_args_t
+ *
+ * @brief Values of the placeholders of a template
+ */
+typedef struct {
+    const item_t *item; /**< Item, for the names and the flag state */
+    long qty;           /**< Quantity */
+    const flag_t *flag; /**< Flag */
+    const cmdv_t *cmd;  /**< Command, for its words */
+} tmpl_args_t;
+
+
+/* Public interface */
+/**
+ * @brief Parses a template
+ *
+ * @param text Template text
+ *
+ * @return Pointer to the template, or @c NULL if a placeholder is not
+ *         valid, a brace is not closed, or it can't allocate memory
+ */
+tmpl_t *tmpl_init(const char *text);
+
+/**
+ * @brief Frees allocated memory
+ *
+ * @param tmpl Template to deallocate
+ */
+void tmpl_destroy(tmpl_t *tmpl);
+
+/**
+ * @brief Prints a template
+ *
+ * @param printer Printer structure
+ * @param tmpl    Template
+ * @param args    Values of the placeholders; a placeholder with no
+ *                value (no item, no flag or no command) prints nothing
+ *
+ * @return Returns the number of bytes added, or a negative number on
+ *         error
+ *
+ * @note The flag is printed with its state in the item, and nothing
+ *       is printed if the item doesn't have it
+ */
+int tmpl_print(printer_t *printer, const tmpl_t *tmpl,
+               const tmpl_args_t *args);
+
+/**
+ * @brief Macro that evaluates to the printing of a template as a line
+ *        (print template)
+ *
+ * @see tmpl_print
+ */
+#define pt(printer, tmpl, args)  \
+    (tmpl_print(printer, tmpl, args) < 0 ? -1 : printer_write(printer, "\n", 1))
+
+
+#endif /* TMPL_H */
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file tokenizer.h
+ *
+ * @brief Splits a sentence in words and classifies them in one pass
+ *
+ * The tokenizer is a deterministic automaton (a trie) built from every
+ * word in a lexicon.  Each byte of the input is mapped to a character
+ * class, where the delimiters have their own class, so walking the
+ * input once is enough to know where every word starts and ends and
+ * which lexeme it is.  The input is not modified, and the tokens are
+ * returned as chunks of it.
+ *
+ * ASCII letters are folded to lowercase, so "OPEN" and "open" are the
+ * same word.
+ *
+ * When the automaton knows a word is not in the lexicon, the rest of
+ * the word is skipped with @e str_span_out, many bytes at a time.
+ *
+ * @code
+ * const char *cursor = sentence;
+ * const char *end = sentence + strlen(sentence);
+ * token_t token;
+ *
+ * while (tokenizer_next(tokenizer, &cursor, end, &token)) {
+ *     ...
+ * }
+ * @endcode
+ */
+
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+/* System includes */
+#include <stdbool.h>    /* bool */
+#include <stddef.h>     /* size_t */
+#include <stdint.h>     /* uint8_t, uint32_t */
+
+/* Local includes */
+#include <lexicon.h>
+#include <strops.h>
+
+
+/**
+ * @typedef token_t
+ *
+ * @brief Word found in a sentence
+ */
+typedef struct {
+    span_t span;        /**< The word, as a chunk of the sentence */
+    lexeme_t lex;       /**< Lexeme type, @c LEX_UNK if not known */
+    uint32_t entry;     /**< Index of the word in the lexicon plus one,
+                             which is also its atom, or 0 if not known */
+} token_t;
+
+
+/**
+ * @typedef tokenizer_t
+ *
+ * @brief Automaton that recognizes the words of a lexicon
+ *
+ * The state 0 is a dead state, reached when the word can't be in the
+ * lexicon, and the state 1 is the initial state.
+ */
+typedef struct {
+    const lexicon_t *lexicon;   /**< Lexicon of known words */
+    uint8_t classes[256];       /**< Class of each byte, 0 if delimiter */
+    size_t nclasses;            /**< Number of classes */
+    uint32_t *trans;            /**< Next state by state and class */
+    uint32_t *accept;           /**< Entry + 1 accepted by state, or 0 */
+    size_t nstates;             /**< Number of states */
+    size_t cap;                 /**< Allocated number of states */
+    charset_t delims;           /**< Bytes of class 0 */
+} tokenizer_t;
+
+
+/* Public interface */
+/**
+ * @brief Builds a tokenizer for all words in a lexicon
+ *
+ * @param lexicon Lexicon (already built) with the words to recognize
+ * @param delims  Characters that separate words
+ *
+ * @return Pointer to the newly created tokenizer, or @c NULL otherwise
+ *
+ * @note The lexicon must outlive the tokenizer
+ */
+tokenizer_t *tokenizer_init(const lexicon_t *lexicon, const char *delims);
+
+/**
+ * @brief Sets the delimiters of a tokenizer from its classes
+ *
+ * @param tokenizer Tokenizer whose classes are already set
+ *
+ * @note Called by @e tokenizer_init and @e lexfile_load
+ */
+void tokenizer_init_delims(tokenizer_t *tokenizer);
+
+/**
+ * @brief Frees allocated memory
+ *
+ * @param tokenizer Tokenizer to deallocate
+ */
+void tokenizer_destroy(tokenizer_t *tokenizer);
+
+/**
+ * @brief Gets the next word of a sentence
+ *
+ * @param tokenizer Tokenizer to use
+ * @param cursor    Position in the sentence, updated after the word
+ * @param end       End of the sentence
+ * @param token     Where to store the word found
+ *
+ * @return @c true if there was a word, or @c false at the end of the
+ *         sentence
+ */
+bool tokenizer_next(const tokenizer_t *tokenizer, const char **cursor,
+                    const char *end, token_t *token);
+
+
+#endif /* TOKENIZER_H */
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file turn.h
+ *
+ * @brief Handling of a line of input of a player
+ *
+ * A turn takes a line typed by a player, parses it, and leaves the
+ * answer in the printer of the player, whatever the line came from:
+ * the terminal, a session of the server, or a file.
+ *
+ * @code
+ * turn_t turn;
+ * turn_init_at(&turn, out);
+ * while (!turn.quit && read_line(line, &len)) {
+ *     turn_line(&turn, line, len);
+ *     turn_prompt(&turn);
+ *     printer_flush(out);
+ * }
+ * @endcode
+ */
+
+#ifndef TURN_H
+#define TURN_H
+
+/* System includes */
+#include <stdbool.h>    /* bool */
+#include <stddef.h>     /* size_t */
+
+/* Local includes */
+#include <printer.h>
+
+#define TURN_PROMPT  " > "      /**< Shown when waiting for a line */
+#define TURN_QUIT    "quit"     /**< Line that ends the game */
+
+
+/**
+ * @typedef turn_t
+ *
+ * @brief State of the commands of a player
+ */
+typedef struct {
+    printer_t *out;     /**< Where the answers go */
+    size_t count;       /**< Lines handled */
+    bool quit;          /**< Whether the player asked to leave */
+} turn_t;
+
+
+/* Public interface */
+/**
+ * @brief Initializes the state of a player in place
+ *
+ * @param turn State to initialize
+ * @param out  Printer where the answers go
+ */
+void turn_init_at(turn_t *turn, printer_t *out);
+
+/**
+ * @brief Handles a line of input
+ *
+ * The line is copied to the memory of the turn, so it's not modified
+ * and it has no length limit, and that memory is freed at the end.
+ *
+ * @param turn State of the player
+ * @param line Line (not necessarily null-terminated)
+ * @param len  Length of the line
+ *
+ * @return Returns what @e parse_normalized returns, or -2 if there's
+ *         no memory for the line
+ *
+ * @see parse_normalized, parser_turn
+ */
+int turn_line(turn_t *turn, const char *line, size_t len);
+
+/**
+ * @brief Adds the prompt to the output of a player
+ *
+ * @param turn State of the player
+ */
+void turn_prompt(turn_t *turn);
+
+
+#endif /* TURN_H */
+
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file widx.h
+ *
+ * @brief Inverted index of words
+ *
+ * For every word, as an atom, the index keeps the sorted list of the
+ * identifiers of the items that have it, so the items that have two
+ * words are the intersection of two lists, instead of looking at the
+ * words of every item.
+ *
+ * @code
+ * size_t n_red, n_key;
+ * const uint32_t *red = widx_get(&adjs, atom_find_str("red"), &n_red);
+ * const uint32_t *key = widx_get(&nouns, atom_find_str("key"), &n_key);
+ * n = widx_intersect(red, n_red, key, n_key, ids);
+ * @endcode
+ *
+ * @see item_find
+ */
+
+#ifndef WIDX_H
+#define WIDX_H
+
+/* System includes */
+#include <stdbool.h>    /* bool */
+#include <stddef.h>     /* size_t */
+#include <stdint.h>     /* uint32_t */
+
+/* Local includes */
+#include <atom.h>
+
+
+/**
+ * @typedef widx_list_t
+ *
+ * @brief Identifiers of the items that have a word
+ */
+typedef struct {
+    atom_t atom;    /**< Word, @c ATOM_NONE if the entry is empty */
+    uint32_t len;   /**< Number of identifiers */
+    uint32_t cap;   /**< Allocated length of @e ids */
+    uint32_t *ids;  /**< Identifiers, sorted */
+} widx_list_t;
+
+
+/**
+ * @typedef widx_t
+ *
+ * @brief Inverted index, as a hash table (open addressing, linear
+ *        probing) of lists of identifiers by word
+ */
+typedef struct {
+    widx_list_t *lists; /**< Hash table of lists */
+    size_t cap;         /**< Size of the table, a power of two, or 0 */
+    size_t len;         /**< Number of words in the table */
+} widx_t;
+
+
+/**
+ * @brief Static initializer of an empty index
+ */
+#define WIDX_INIT  { NULL, 0, 0 }
+
+
+/* Public interface */
+/**
+ * @brief Initializes an empty index already allocated
+ *
+ * @param widx Index to initialize
+ */
+void widx_init_at(widx_t *widx);
+
+/**
+ * @brief Frees the memory used by an index, but not the index itself
+ *
+ * @param widx Index to destroy
+ */
+void widx_destroy_at(widx_t *widx);
+
+/**
+ * @brief Adds an identifier to the list of a word
+ *
+ * @param widx Index
+ * @param atom Word
+ * @param id   Identifier
+ *
+ * @return @c true if it's added, or @c false if it was already in the
+ *         list or it can't allocate memory
+ */
+bool widx_add(widx_t *widx, atom_t atom, uint32_t id);
+
+/**
+ * @brief Removes an identifier from the list of a word
+ *
+ * @param widx Index
+ * @param atom Word
+ * @param id   Identifier
+ *
+ * @return @c true if it's removed, or @c false if it wasn't in the list
+ */
+bool widx_rem(widx_t *widx, atom_t atom, uint32_t id);
+
+/**
+ * @brief Gets the list of a word
+ *
+ * @param widx Index
+ * @param atom Word
+ * @param len  Where to save the length of the list
+ *
+ * @return Sorted identifiers of the items with the word, valid until
+ *         the index is modified, or @c NULL if there are none
+ */
+const uint32_t *widx_get(const widx_t *widx, atom_t atom, size_t *len);
+
+/**
+ * @brief Intersects two sorted lists of identifiers
+ *
+ * @param a   First list
+ * @param na  Length of the first list
+ * @param b   Second list
+ * @param nb  Length of the second list
+ * @param out Where to save the identifiers in both lists, sorted, with
+ *            room for the shortest list
+ *
+ * @return Number of identifiers in both lists
+ */
+size_t widx_intersect(const uint32_t *a, size_t na,
+                      const uint32_t *b, size_t nb, uint32_t *out);
+
+
+#endif /* WIDX_H */
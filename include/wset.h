@@ -15,6 +15,19 @@
  * @file wset.h
  *
  * @brief Word set operations declaration
+ *
+ * The set keeps the atoms of its words, not the words, in a hash
+ * table, so looking a word up, adding it or removing it takes constant
+ * time, and every word is stored once in the table of atoms (which
+ * works as the arena of strings) no matter how many sets have it.
+ *
+ * Most sets have just a few words, so the first @c WSET_SMALL atoms
+ * are kept inside the set itself, and the table is only allocated when
+ * the set outgrows them.  A set can be part of another structure, with
+ * @e wset_init_at and @e wset_destroy_at, needing no allocation at all
+ * while it's small.
+ *
+ * @see atom.h
  */
 
 #ifndef WSET_H
@@ -22,6 +35,12 @@
 
 /* System includes */
 #include <stdbool.h>    /* bool */
+#include <stddef.h>     /* size_t */
+
+/* Local includes */
+#include <atom.h>
+
+#define WSET_SMALL  (4)     /**< Atoms kept inside the set */
 
 
 /**
@@ -30,8 +49,12 @@
  * @brief Set of words
  */
 typedef struct {
-    char **words;   /**< Array of strings */
-    size_t len;     /**< Size of array */
+    union {
+        atom_t small[WSET_SMALL];   /**< Atoms, while @e cap is 0 */
+        atom_t *words;  /**< Hash table of atoms, @c ATOM_NONE if empty */
+    };
+    size_t cap;     /**< Size of the table, a power of two, or 0 */
+    size_t len;     /**< Number of words */
     size_t bytes;   /**< Sum of all lengths of all words */
 } wset_t;
 
@@ -44,10 +67,30 @@ typedef struct {
  */
 wset_t *wset_init(void);
 
+/**
+ * @brief Initializes an empty bag of words in place
+ *
+ * @param wset Word set to initialize
+ *
+ * @see wset_destroy_at
+ */
+void wset_init_at(wset_t *wset);
+
+/**
+ * @brief Frees the memory allocated by a word set initialized in place
+ *
+ * @param wset Word set to finalize
+ *
+ * @see wset_init_at
+ */
+void wset_destroy_at(wset_t *wset);
+
 /**
  * @brief Frees allocated memory
  *
- * @param wset Word set to deallocate
+ * @param wset          Word set to deallocate
+ * @param destroy_words Unused, as the words belong to the table of
+ *                      atoms and they are never freed one by one
  */
 void wset_destroy(wset_t *wset, bool destroy_words);
 
@@ -61,6 +104,16 @@ void wset_destroy(wset_t *wset, bool destroy_words);
  */
 bool wset_has_word(wset_t *wset, const char *word);
 
+/**
+ * @brief Checks if the word of an atom is contained in the set
+ *
+ * @param wset Word set to search in
+ * @param atom Atom of the word to look up
+ *
+ * @return @c true if the word is on the set, or @c false otherwise
+ */
+bool wset_has_atom(wset_t *wset, atom_t atom);
+
 /**
  * @brief Adds a new word to the set of words
  *
@@ -77,6 +130,19 @@ bool wset_has_word(wset_t *wset, const char *word);
  */
 bool wset_add(wset_t *wset, const char *word);
 
+/**
+ * @brief Adds the word of an atom to the set of words
+ *
+ * @param wset Word set where to insert the new word
+ * @param atom Atom of the word to insert in the word set
+ *
+ * @return @c true if the word is successufuly inserted in the word set,
+ *         or @c false otherwise
+ *
+ * @see wset_add
+ */
+bool wset_add_atom(wset_t *wset, atom_t atom);
+
 /**
  * @brief Removes a word from the set of words
  *
@@ -90,12 +156,22 @@ bool wset_add(wset_t *wset, const char *word);
  * @pre The word set mustn't be empty
  *
  * @see wset_has_word
- *
- * @bug Segfault when adding a new word after removing another.
- *      Check memory management in this function (@c realloc)
  */
 bool wset_rem(wset_t *wset, const char *word);
 
+/**
+ * @brief Removes the word of an atom from the set of words
+ *
+ * @param wset Word set where to remove the word
+ * @param atom Atom of the word to remove
+ *
+ * @return @c true if the word is successufuly removed from the word
+ *         set, or @c false otherwise
+ *
+ * @see wset_rem
+ */
+bool wset_rem_atom(wset_t *wset, atom_t atom);
+
 /**
  * @brief Replaces a string with another
  *
@@ -116,10 +192,24 @@ bool wset_replace(wset_t *wset, const char *old, const char *new);
  * @param wset Word set to operate to
  * @param f    Function to apply to each and every member of the set
  *
- * @note The signature of the function must be `void f(char *)`
+ * @note The signature of the function must be `void f(char *)`.  It's
+ *       applied to a copy of every word, and the result is interned
+ *       again, so a word changed into another already in the set is
+ *       kept only once
  */
 void wset_map(wset_t *wset, void (*f)(char *));
 
+/**
+ * @brief Calls a function with every atom of the set
+ *
+ * @param wset Word set
+ * @param f    Function called with every atom and @e data
+ * @param data Data passed to the function
+ *
+ * @warning The set must not be modified by the function
+ */
+void wset_each(const wset_t *wset, void (*f)(atom_t, void *), void *data);
+
 /**
  * @brief Macro that evaluates to a hard destroy of the object
  *
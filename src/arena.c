@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file arena.c
+ *
+ * @brief Memory that is freed all at once implementation
+ *
+ * Resetting only goes back to the first chunk; every chunk is emptied
+ * when the arena gets to it again.  A piece bigger than a chunk gets a
+ * chunk of its own, also kept for the next turns.
+ */
+
+/* System includes */
+#include <stdalign.h>   /* alignof */
+#include <stddef.h>     /* max_align_t */
+#include <stdlib.h>     /* malloc, free */
+#include <string.h>     /* memcpy */
+
+/* Local includes */
+#include <arena.h>
+
+#define ARENA_ALIGN  (alignof(max_align_t)) /**< Alignment of a piece */
+
+
+/* Creates a chunk with room for at least 'size' bytes */
+static arena_chunk_t *arena_chunk(size_t size)
+{
+    arena_chunk_t *chunk;
+
+    if (!(chunk = malloc(sizeof(arena_chunk_t) + size))) {
+        return NULL;
+    }
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+
+    return chunk;
+}
+
+
+/* Creates an empty arena */
+arena_t *arena_init(size_t chunk)
+{
+    arena_t *arena;
+
+    if (!(arena = malloc(sizeof(arena_t)))) {
+        return NULL;
+    }
+    arena->chunk = chunk ? chunk : ARENA_CHUNK;
+    if (!(arena->head = arena_chunk(arena->chunk))) {
+        free(arena);
+        return NULL;
+    }
+    arena->cur = arena->head;
+
+    return arena;
+}
+
+
+/* Frees the arena and all its memory */
+void arena_destroy(arena_t *arena)
+{
+    if (!arena) {
+        return;
+    }
+    while (arena->head) {
+        arena_chunk_t *next = arena->head->next;
+        free(arena->head);
+        arena->head = next;
+    }
+    free(arena);
+}
+
+
+/* Takes memory from an arena */
+void *arena_alloc(arena_t *arena, size_t size)
+{
+    arena_chunk_t *cur = arena->cur;
+    size_t start = (cur->used + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+    /* Look for room in the next chunks, emptying them */
+    while (start + size > cur->size) {
+        if (!cur->next) {
+            size_t need = size > arena->chunk ? size : arena->chunk;
+            if (!(cur->next = arena_chunk(need))) {
+                return NULL;
+            }
+        }
+        cur = cur->next;
+        cur->used = 0;
+        start = 0;
+    }
+    cur->used = start + size;
+    arena->cur = cur;
+
+    return cur->data + start;
+}
+
+
+/* Copies a string into an arena */
+char *arena_strndup(arena_t *arena, const char *s, size_t len)
+{
+    char *copy;
+
+    if (!s || !(copy = arena_alloc(arena, len + 1))) {
+        return NULL;
+    }
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+
+    return copy;
+}
+
+
+/* Gives back all the memory of an arena at once */
+void arena_reset(arena_t *arena)
+{
+    arena->cur = arena->head;
+    arena->head->used = 0;
+}
+
+
+/* Gets the number of bytes given since the arena was reset */
+size_t arena_used(const arena_t *arena)
+{
+    size_t used = 0;
+
+    for (const arena_chunk_t *chunk = arena->head; chunk != arena->cur;
+            chunk = chunk->next) {
+        used += chunk->used;
+    }
+
+    return used + arena->cur->used;
+}
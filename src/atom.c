@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file atom.c
+ *
+ * @brief Interned words implementation
+ *
+ * The words that are not in the lexicon are copied, one after another,
+ * in chunks of memory that never move, and their records are kept in
+ * blocks of fixed size, so the word of an atom can be read without
+ * taking any lock.  A hash table (open addressing) maps words to
+ * atoms, and it's only used under the lock.
+ */
+
+/* System includes */
+#include <ctype.h>      /* tolower */
+#include <pthread.h>    /* pthread_mutex_* */
+#include <stdatomic.h>  /* atomic_size_t, atomic_bool, atomic_load, ... */
+#include <stdint.h>     /* uint32_t */
+#include <stdlib.h>     /* malloc, calloc, free */
+#include <string.h>     /* memcmp, memcpy */
+
+/* Local includes */
+#include <atom.h>
+#include <lexicon.h>
+
+#define ATOM_CHUNK       (64 * 1024)    /**< Bytes of a chunk of words */
+#define ATOM_BLOCK       (4096)         /**< Records in a block */
+#define ATOM_MAX_BLOCKS  (4096)         /**< Maximum number of blocks */
+#define ATOM_FOLD_LEN    (64)           /**< Words folded on the stack */
+
+
+/* Word not in the lexicon */
+typedef struct {
+    const char *s;
+    uint32_t len;
+    uint32_t hash;
+} atom_rec_t;
+
+/* Chunk of memory where the words are copied */
+typedef struct atom_chunk {
+    struct atom_chunk *next;
+    size_t used;
+    size_t size;
+    char data[];
+} atom_chunk_t;
+
+
+static const lexicon_t *atom_lexicon = NULL;    /**< Lexicon of the parser */
+static atom_t atom_base = 0;                    /**< Atoms of the lexicon */
+static atomic_size_t atom_count;                /**< Other atoms */
+static atomic_bool atom_given;                  /**< Some atom was given */
+static atom_rec_t *atom_blocks[ATOM_MAX_BLOCKS];/**< Records of atoms */
+static atom_chunk_t *atom_chunks = NULL;        /**< Copies of the words */
+static atom_t *atom_table = NULL;               /**< Hash table of atoms */
+static size_t atom_table_size = 0;              /**< Size of the table */
+static pthread_mutex_t atom_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* Hashes a word (FNV-1a) */
+static inline uint32_t atom_hash(const char *s, size_t len)
+{
+    uint32_t h = 2166136261u;
+
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char) s[i];
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+
+/* Record of an atom not in the lexicon */
+static inline atom_rec_t *atom_rec(atom_t atom)
+{
+    size_t i = atom - atom_base - 1;
+
+    return &atom_blocks[i / ATOM_BLOCK][i % ATOM_BLOCK];
+}
+
+
+/* Binds the table of atoms to a lexicon */
+int atom_init(const lexicon_t *lexicon)
+{
+    atom_destroy();
+
+    pthread_mutex_lock(&atom_lock);
+    atom_lexicon = lexicon;
+    atom_base = lexicon ? lexicon_len(lexicon) : 0;
+    pthread_mutex_unlock(&atom_lock);
+
+    return 0;
+}
+
+
+/* Forgets every atom */
+void atom_destroy(void)
+{
+    pthread_mutex_lock(&atom_lock);
+    for (size_t i = 0; i < ATOM_MAX_BLOCKS && atom_blocks[i]; ++i) {
+        free(atom_blocks[i]);
+        atom_blocks[i] = NULL;
+    }
+    while (atom_chunks) {
+        atom_chunk_t *next = atom_chunks->next;
+        free(atom_chunks);
+        atom_chunks = next;
+    }
+    free(atom_table);
+    atom_table = NULL;
+    atom_table_size = 0;
+    atomic_store(&atom_count, 0);
+    atomic_store(&atom_given, false);
+    atom_lexicon = NULL;
+    atom_base = 0;
+    pthread_mutex_unlock(&atom_lock);
+}
+
+
+/* Slot of a word in the hash table, empty if not there */
+static size_t atom_slot(const char *s, size_t len, uint32_t hash)
+{
+    size_t mask = atom_table_size - 1;
+    size_t pos = hash & mask;
+
+    while (atom_table[pos]) {
+        const atom_rec_t *rec = atom_rec(atom_table[pos]);
+        if (rec->hash == hash && rec->len == len &&
+                memcmp(rec->s, s, len) == 0) {
+            break;
+        }
+        pos = (pos + 1) & mask;
+    }
+
+    return pos;
+}
+
+
+/* Doubles the hash table */
+static int atom_grow(void)
+{
+    size_t size = atom_table_size ? atom_table_size * 2 : 1024;
+    atom_t *table;
+    atom_t *old = atom_table;
+    size_t old_size = atom_table_size;
+
+    if (!(table = calloc(size, sizeof(atom_t)))) {
+        return 1;
+    }
+    atom_table = table;
+    atom_table_size = size;
+    for (size_t i = 0; i < old_size; ++i) {
+        if (old[i]) {
+            const atom_rec_t *rec = atom_rec(old[i]);
+            atom_table[atom_slot(rec->s, rec->len, rec->hash)] = old[i];
+        }
+    }
+    free(old);
+
+    return 0;
+}
+
+
+/* Copies a word into the chunks */
+static const char *atom_copy(const char *s, size_t len)
+{
+    char *copy;
+
+    if (!atom_chunks || atom_chunks->used + len + 1 > atom_chunks->size) {
+        size_t size = len + 1 > ATOM_CHUNK ? len + 1 : ATOM_CHUNK;
+        atom_chunk_t *chunk = malloc(sizeof(atom_chunk_t) + size);
+        if (!chunk) {
+            return NULL;
+        }
+        chunk->next = atom_chunks;
+        chunk->used = 0;
+        chunk->size = size;
+        atom_chunks = chunk;
+    }
+
+    copy = atom_chunks->data + atom_chunks->used;
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    atom_chunks->used += len + 1;
+
+    return copy;
+}
+
+
+/* Looks up a word in the lexicon */
+static atom_t atom_lexicon_find(const char *s, size_t len)
+{
+    const lexentry_t *entry;
+
+    if ((entry = lexicon_find(atom_lexicon, s, len))) {
+        return (entry - atom_lexicon->entries) + 1;
+    }
+
+    return ATOM_NONE;
+}
+
+
+/* Copies a word in lowercase, where there's room for it */
+static char *atom_fold(char *buf, const char *s, size_t len)
+{
+    char *word = len <= ATOM_FOLD_LEN ? buf : malloc(len);
+
+    if (word) {
+        for (size_t i = 0; i < len; ++i) {
+            word[i] = tolower((unsigned char) s[i]);
+        }
+    }
+
+    return word;
+}
+
+
+/* Gets the atom of a lowercase word only if it's already interned */
+static atom_t atom_find_folded(const char *s, size_t len)
+{
+    atom_t atom;
+    uint32_t hash;
+
+    if ((atom = atom_lexicon_find(s, len))) {
+        return atom;
+    }
+
+    hash = atom_hash(s, len);
+    pthread_mutex_lock(&atom_lock);
+    atom = atom_table_size ? atom_table[atom_slot(s, len, hash)] : ATOM_NONE;
+    pthread_mutex_unlock(&atom_lock);
+
+    return atom;
+}
+
+
+/* Notes that an atom was given, so the lexicon can't be changed */
+static inline atom_t atom_give(atom_t atom)
+{
+    if (atom != ATOM_NONE && !atomic_load_explicit(&atom_given,
+                                                   memory_order_relaxed)) {
+        atomic_store(&atom_given, true);
+    }
+
+    return atom;
+}
+
+
+/* Gets the atom of a word only if it's already interned */
+atom_t atom_find(const char *s, size_t len)
+{
+    char buf[ATOM_FOLD_LEN];
+    char *word;
+    atom_t atom;
+
+    if (!atom_lexicon || !s || len == 0 ||
+            !(word = atom_fold(buf, s, len))) {
+        return ATOM_NONE;
+    }
+    atom = atom_give(atom_find_folded(word, len));
+    if (word != buf) {
+        free(word);
+    }
+
+    return atom;
+}
+
+
+/* Gets the atom of a lowercase word, interning it if it's new */
+static atom_t atom_intern_folded(const char *s, size_t len)
+{
+    atom_rec_t *rec;
+    atom_t atom;
+    size_t count;
+    size_t pos;
+    uint32_t hash;
+
+    if ((atom = atom_lexicon_find(s, len))) {
+        return atom;
+    }
+
+    hash = atom_hash(s, len);
+    pthread_mutex_lock(&atom_lock);
+    count = atomic_load(&atom_count);
+
+    /* Keep the table at most half full */
+    if ((count + 1) * 2 > atom_table_size && atom_grow() != 0) {
+        pthread_mutex_unlock(&atom_lock);
+        return ATOM_NONE;
+    }
+    pos = atom_slot(s, len, hash);
+    if ((atom = atom_table[pos])) {     /* already interned */
+        pthread_mutex_unlock(&atom_lock);
+        return atom;
+    }
+
+    if (count / ATOM_BLOCK >= ATOM_MAX_BLOCKS ||
+            (!atom_blocks[count / ATOM_BLOCK] &&
+             !(atom_blocks[count / ATOM_BLOCK] =
+                 malloc(sizeof(atom_rec_t) * ATOM_BLOCK)))) {
+        pthread_mutex_unlock(&atom_lock);
+        return ATOM_NONE;
+    }
+
+    atom = atom_base + count + 1;
+    rec = atom_rec(atom);
+    if (!(rec->s = atom_copy(s, len))) {
+        pthread_mutex_unlock(&atom_lock);
+        return ATOM_NONE;
+    }
+    rec->len = len;
+    rec->hash = hash;
+    atom_table[pos] = atom;
+    atomic_store(&atom_count, count + 1);
+    pthread_mutex_unlock(&atom_lock);
+
+    return atom;
+}
+
+
+/* Gets the atom of a word, interning it if it's new */
+atom_t atom_intern(const char *s, size_t len)
+{
+    char buf[ATOM_FOLD_LEN];
+    char *word;
+    atom_t atom;
+
+    if (!atom_lexicon || !s || len == 0 || len > UINT32_MAX ||
+            !(word = atom_fold(buf, s, len))) {
+        return ATOM_NONE;
+    }
+    atom = atom_give(atom_intern_folded(word, len));
+    if (word != buf) {
+        free(word);
+    }
+
+    return atom;
+}
+
+
+/* Checks if some atom has been given since the lexicon was bound */
+bool atom_in_use(void)
+{
+    return atomic_load(&atom_given);
+}
+
+
+/* Gets the word of an atom */
+const char *atom_str(atom_t atom)
+{
+    if (atom == ATOM_NONE) {
+        return NULL;
+    }
+    if (atom <= atom_base) {
+        return lexicon_word(atom_lexicon, &atom_lexicon->entries[atom - 1]);
+    }
+    if (atom - atom_base > atomic_load(&atom_count)) {
+        return NULL;
+    }
+
+    return atom_rec(atom)->s;
+}
+
+
+/* Gets the length of the word of an atom */
+size_t atom_len(atom_t atom)
+{
+    if (atom == ATOM_NONE) {
+        return 0;
+    }
+    if (atom <= atom_base) {
+        return atom_lexicon->entries[atom - 1].len;
+    }
+    if (atom - atom_base > atomic_load(&atom_count)) {
+        return 0;
+    }
+
+    return atom_rec(atom)->len;
+}
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file batch.c
+ *
+ * @brief Batch parsing implementation
+ *
+ * The calling thread works as one more thread.  When parsing a file,
+ * the threads are created once and they sleep between windows of
+ * lines, so the cost of creating them is not paid again and again.
+ */
+
+/* System includes */
+#include <fcntl.h>      /* open */
+#include <pthread.h>    /* pthread_create, pthread_join, pthread_cond_* */
+#include <stdatomic.h>  /* atomic_size_t, atomic_fetch_add */
+#include <stdbool.h>    /* bool, true, false */
+#include <stdlib.h>     /* malloc, free */
+#include <string.h>     /* memchr */
+#include <sys/mman.h>   /* mmap, munmap, madvise */
+#include <sys/stat.h>   /* fstat */
+#include <unistd.h>     /* close, sysconf */
+
+/* Local includes */
+#include <batch.h>
+#include <cmd.h>
+#include <parser.h>
+#include <strops.h>
+
+
+/* Work shared among threads */
+typedef struct {
+    const span_t *lines;
+    cmdlist_t *results;
+    size_t n;
+    atomic_size_t next;         /* First line not taken by any thread */
+
+    pthread_mutex_t lock;       /* Protects the fields below */
+    pthread_cond_t wake;        /* A new window is ready to be parsed */
+    pthread_cond_t idle;        /* Every thread ended with the window */
+    unsigned window;            /* Number of the window being parsed */
+    unsigned busy;              /* Threads still parsing the window */
+    bool done;                  /* No more windows to parse */
+} batch_job_t;
+
+
+/* Number of threads to use */
+static unsigned batch_nthreads(unsigned nthreads)
+{
+    long ncores;
+
+    if (nthreads) {
+        return nthreads < BATCH_THREADS_MAX ? nthreads : BATCH_THREADS_MAX;
+    }
+    ncores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return ncores <= 0 ? 1 : ncores < BATCH_THREADS_MAX ?
+           (unsigned) ncores : BATCH_THREADS_MAX;
+}
+
+
+/* Parses chunks of lines until there are no more */
+static void batch_run(batch_job_t *job)
+{
+    size_t first;
+
+    while ((first = atomic_fetch_add(&job->next, BATCH_CHUNK)) < job->n) {
+        size_t last = first + BATCH_CHUNK < job->n ? first + BATCH_CHUNK
+                                                   : job->n;
+        for (size_t i = first; i < last; ++i) {
+            parse_line(job->lines[i].s, job->lines[i].len,
+                       &job->results[i]);
+        }
+    }
+}
+
+
+/* Thread parsing a single array of lines */
+static void *batch_once(void *arg)
+{
+    batch_run(arg);
+
+    return NULL;
+}
+
+
+/* Thread parsing every window of a file */
+static void *batch_loop(void *arg)
+{
+    batch_job_t *job = arg;
+    unsigned window = 0;
+
+    pthread_mutex_lock(&job->lock);
+    for (;;) {
+        while (job->window == window && !job->done) {
+            pthread_cond_wait(&job->wake, &job->lock);
+        }
+        if (job->done) {
+            break;
+        }
+        window = job->window;
+        pthread_mutex_unlock(&job->lock);
+
+        batch_run(job);
+
+        pthread_mutex_lock(&job->lock);
+        if (--job->busy == 0) {
+            pthread_cond_signal(&job->idle);
+        }
+    }
+    pthread_mutex_unlock(&job->lock);
+
+    return NULL;
+}
+
+
+/* Parses an array of lines */
+int batch_parse(const span_t *lines, size_t n, cmdlist_t *results,
+                unsigned nthreads)
+{
+    batch_job_t job = { .lines = lines, .results = results, .n = n };
+    pthread_t *threads;
+    unsigned created = 0;
+
+    if (parser_init() != 0) {
+        return 1;
+    }
+
+    nthreads = batch_nthreads(nthreads);
+    if (!(threads = malloc(sizeof(pthread_t) * nthreads))) {
+        return 1;
+    }
+
+    atomic_init(&job.next, 0);
+    while (created + 1 < nthreads &&
+            pthread_create(&threads[created], NULL, batch_once, &job) == 0) {
+        created++;
+    }
+    batch_run(&job);
+    while (created) {
+        pthread_join(threads[--created], NULL);
+    }
+
+    free(threads);
+
+    return 0;
+}
+
+
+/* Parses a window of lines and gives them back in order */
+static void batch_window(batch_job_t *job, const span_t *lines, size_t n,
+                         unsigned nworkers, size_t lineno, batch_cb_t f,
+                         void *data)
+{
+    pthread_mutex_lock(&job->lock);
+    job->n = n;
+    atomic_store(&job->next, 0);
+    job->window++;
+    job->busy = nworkers;
+    pthread_cond_broadcast(&job->wake);
+    pthread_mutex_unlock(&job->lock);
+
+    batch_run(job);
+
+    pthread_mutex_lock(&job->lock);
+    while (job->busy) {
+        pthread_cond_wait(&job->idle, &job->lock);
+    }
+    pthread_mutex_unlock(&job->lock);
+
+    for (size_t i = 0; i < n; ++i) {
+        f(lineno + i, lines[i], &job->results[i], data);
+    }
+}
+
+
+/* Parses every line of a file */
+int batch_parse_file(const char *path, unsigned nthreads, batch_cb_t f,
+                     void *data)
+{
+    batch_job_t job = { .lock = PTHREAD_MUTEX_INITIALIZER,
+                        .wake = PTHREAD_COND_INITIALIZER,
+                        .idle = PTHREAD_COND_INITIALIZER };
+    span_t *lines;
+    pthread_t *threads;
+    unsigned created = 0;
+    struct stat st;
+    const char *map;
+    const char *p;
+    const char *end;
+    size_t n = 0;
+    size_t lineno = 1;
+    int fd;
+
+    if (!path || !f || parser_init() != 0) {
+        return 1;
+    }
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        return 2;
+    }
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return 2;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return 2;
+    }
+    madvise((void *) map, st.st_size, MADV_SEQUENTIAL);
+
+    nthreads = batch_nthreads(nthreads);
+    lines = malloc(sizeof(span_t) * BATCH_WINDOW);
+    job.results = malloc(sizeof(cmdlist_t) * BATCH_WINDOW);
+    threads = malloc(sizeof(pthread_t) * nthreads);
+    if (!lines || !job.results || !threads) {
+        free(lines);
+        free(job.results);
+        free(threads);
+        munmap((void *) map, st.st_size);
+        return 1;
+    }
+    job.lines = lines;
+    atomic_init(&job.next, 0);
+
+    while (created + 1 < nthreads &&
+            pthread_create(&threads[created], NULL, batch_loop, &job) == 0) {
+        created++;
+    }
+
+    /* Split lines, and parse them every time a window is full */
+    for (p = map, end = map + st.st_size; p < end; ) {
+        const char *eol = memchr(p, '\n', end - p);
+        const char *next = eol ? eol + 1 : end;
+
+        if (!eol) {
+            eol = end;
+        }
+        if (eol > p && eol[-1] == '\r') {
+            --eol;
+        }
+        lines[n].s = p;
+        lines[n].len = eol - p;
+        p = next;
+
+        if (++n == BATCH_WINDOW) {
+            batch_window(&job, lines, n, created, lineno, f, data);
+            lineno += n;
+            n = 0;
+        }
+    }
+    if (n) {
+        batch_window(&job, lines, n, created, lineno, f, data);
+    }
+
+    /* Wake up threads to finish them */
+    pthread_mutex_lock(&job.lock);
+    job.done = true;
+    pthread_cond_broadcast(&job.wake);
+    pthread_mutex_unlock(&job.lock);
+    while (created) {
+        pthread_join(threads[--created], NULL);
+    }
+
+    free(lines);
+    free(job.results);
+    free(threads);
+    munmap((void *) map, st.st_size);
+
+    return 0;
+}
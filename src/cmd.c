@@ -18,12 +18,18 @@
  */
 
 /* System includes */
-#include <stdbool.h>    /* bool */
 #include <stdlib.h>     /* malloc, free */
 
 /* Local includes */
+#include <atom.h>
 #include <cmd.h>
-#include <strops.h>
+
+
+/* Interns a word, if any */
+static inline atom_t cmd_atom(const char *word)
+{
+    return word ? atom_intern_str(word) : ATOM_NONE;
+}
 
 
 /* Initializes a command indicating every chunck of the sentence */
@@ -37,27 +43,46 @@ cmd_t *cmd_init(const char *action, const char *mode,
         return NULL;
     }
 
-    cmd->action = str_alloc_cpy(action);
-    cmd->mode = str_alloc_cpy(mode);
-    cmd->quantity = str_alloc_cpy(quantity);
-    cmd->quality = str_alloc_cpy(quality);
-    cmd->dobj = str_alloc_cpy(dobj);
-    cmd->iobj = str_alloc_cpy(iobj);
+    cmd->action = cmd_atom(action);
+    cmd->mode = cmd_atom(mode);
+    cmd->quantity = cmd_atom(quantity);
+    cmd->quality = cmd_atom(quality);
+    cmd->dobj = cmd_atom(dobj);
+    cmd->iobj = cmd_atom(iobj);
 
     return cmd;
 }
 
 
+/* Copies the atoms of a view into a command */
+static cmd_t *cmd_copy_view(cmd_t *cmd, const cmdv_t *view)
+{
+    cmd->action = view->action.atom;
+    cmd->mode = view->mode.atom;
+    cmd->quantity = view->quantity.atom;
+    cmd->quality = view->quality.atom;
+    cmd->dobj = view->dobj.atom;
+    cmd->iobj = view->iobj.atom;
+
+    return cmd;
+}
+
+
+/* Initializes a command with the atoms of a view */
+cmd_t *cmd_init_view(const cmdv_t *view)
+{
+    cmd_t *cmd;
+
+    if (!view || !(cmd = malloc(sizeof(cmd_t)))) {
+        return NULL;
+    }
+
+    return cmd_copy_view(cmd, view);
+}
+
+
 /* Destroys a command */
 void cmd_destroy(cmd_t *cmd)
 {
-    free(cmd->action);
-    free(cmd->mode);
-    free(cmd->quantity);
-    free(cmd->quality);
-    free(cmd->dobj);
-    free(cmd->iobj);
-
     free(cmd);
 }
-
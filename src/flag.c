@@ -15,16 +15,193 @@
  * @file flag.c
  *
  * @brief Flag routines implementation
+ *
+ * The registry is an array of pointers to flags, indexed by their
+ * identifiers; a new flag takes the lowest free identifier.
+ *
+ * The texts of the flags are kept in a pool, only once each, and
+ * counting how many flags use them, so two flags with the same texts
+ * point to the same strings.  A hash table (open addressing, linear
+ * probing) finds the texts in the pool; removing from it shifts back
+ * the entries that follow in the same run, so there are no tombstones.
  */
 
 /* System includes */
+#include <pthread.h> /* pthread_mutex_* */
 #include <stdbool.h> /* bool */
-#include <stdlib.h>  /* malloc, free */
-#include <string.h>  /* strncmp */
+#include <stddef.h>  /* offsetof */
+#include <stdint.h>  /* uint32_t */
+#include <stdlib.h>  /* malloc, calloc, free */
+#include <string.h>  /* memcmp, memcpy, strlen */
 
 /* Local includes */
 #include <flag.h>
-#include <strops.h>
+
+
+/* Text in the pool */
+typedef struct {
+    size_t refs;
+    size_t len;
+    uint32_t hash;
+    char s[];
+} flag_text_t;
+
+
+static flag_t *flag_registry[FLAG_MAX];     /**< Flags by identifier */
+static uint32_t flag_free = 0;              /**< No free id below this */
+static flag_text_t **flag_pool = NULL;      /**< Hash table of texts */
+static size_t flag_pool_size = 0;           /**< Size of the table */
+static size_t flag_pool_len = 0;            /**< Texts in the table */
+static pthread_mutex_t flag_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* Hashes a text (FNV-1a) */
+static inline uint32_t flag_hash(const char *s, size_t len)
+{
+    uint32_t h = 2166136261u;
+
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char) s[i];
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+
+/* Slot of a text in the pool, empty if not there */
+static size_t flag_pool_slot(const char *s, size_t len, uint32_t hash)
+{
+    size_t mask = flag_pool_size - 1;
+    size_t pos = hash & mask;
+
+    while (flag_pool[pos] && (flag_pool[pos]->hash != hash ||
+                flag_pool[pos]->len != len ||
+                memcmp(flag_pool[pos]->s, s, len) != 0)) {
+        pos = (pos + 1) & mask;
+    }
+
+    return pos;
+}
+
+
+/* Doubles the hash table of the pool */
+static bool flag_pool_grow(void)
+{
+    size_t size = flag_pool_size ? flag_pool_size * 2 : 64;
+    flag_text_t **old = flag_pool;
+    size_t old_size = flag_pool_size;
+
+    if (!(flag_pool = calloc(size, sizeof(flag_text_t *)))) {
+        flag_pool = old;
+        return false;
+    }
+    flag_pool_size = size;
+    for (size_t i = 0; i < old_size; ++i) {
+        if (old[i]) {
+            flag_pool[flag_pool_slot(old[i]->s, old[i]->len,
+                                     old[i]->hash)] = old[i];
+        }
+    }
+    free(old);
+
+    return true;
+}
+
+
+/* Gets a text from the pool, adding it if it's new */
+static const char *flag_text_get(const char *s)
+{
+    flag_text_t *text;
+    size_t len;
+    size_t pos;
+    uint32_t hash;
+
+    if (!s) {
+        return NULL;
+    }
+    len = strlen(s);
+    hash = flag_hash(s, len);
+
+    /* Keep the table at most half full */
+    if ((flag_pool_len + 1) * 2 > flag_pool_size && !flag_pool_grow()) {
+        return NULL;
+    }
+    pos = flag_pool_slot(s, len, hash);
+    if ((text = flag_pool[pos])) {
+        text->refs++;
+        return text->s;
+    }
+
+    if (!(text = malloc(sizeof(flag_text_t) + len + 1))) {
+        return NULL;
+    }
+    text->refs = 1;
+    text->len = len;
+    text->hash = hash;
+    memcpy(text->s, s, len + 1);
+    flag_pool[pos] = text;
+    flag_pool_len++;
+
+    return text->s;
+}
+
+
+/* Releases a text of the pool, freeing it when no flag uses it */
+static void flag_text_put(const char *s)
+{
+    flag_text_t *text;
+    size_t mask = flag_pool_size - 1;
+    size_t pos;
+
+    if (!s) {
+        return;
+    }
+    text = (flag_text_t *) (s - offsetof(flag_text_t, s));
+    if (--text->refs > 0) {
+        return;
+    }
+
+    pos = flag_pool_slot(text->s, text->len, text->hash);
+    for (size_t next = (pos + 1) & mask; flag_pool[next];
+            next = (next + 1) & mask) {
+        size_t home = flag_pool[next]->hash & mask;
+        if (((next - home) & mask) >= ((next - pos) & mask)) {
+            flag_pool[pos] = flag_pool[next];
+            pos = next;
+        }
+    }
+    flag_pool[pos] = NULL;
+    flag_pool_len--;
+    free(text);
+
+    if (flag_pool_len == 0) {
+        free(flag_pool);
+        flag_pool = NULL;
+        flag_pool_size = 0;
+    }
+}
+
+
+/* Gives the lowest free identifier to a flag */
+static bool flag_register(flag_t *flag)
+{
+    uint32_t id;
+
+    pthread_mutex_lock(&flag_lock);
+    for (id = flag_free; id < FLAG_MAX && flag_registry[id]; ++id) {
+        ;
+    }
+    if (id < FLAG_MAX) {
+        flag_registry[id] = flag;
+        flag->id = id;
+        flag_free = id + 1;
+    }
+    pthread_mutex_unlock(&flag_lock);
+
+    return id < FLAG_MAX;
+}
+
 
 /* Initializes new flag */
 flag_t *flag_init(const bool state, const char *yes, const char* no)
@@ -35,9 +212,20 @@ flag_t *flag_init(const bool state, const char *yes, const char* no)
         return NULL;
     }
 
-    flag->state = state;
-    flag->yes = str_alloc_cpy(yes);
-    flag->no = str_alloc_cpy(no);
+    flag->initial = state;
+    if (!flag_register(flag)) {
+        free(flag);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&flag_lock);
+    flag->yes = flag_text_get(yes);
+    flag->no = flag_text_get(no);
+    pthread_mutex_unlock(&flag_lock);
+    if ((yes && !flag->yes) || (no && !flag->no)) {
+        flag_destroy(flag);
+        return NULL;
+    }
 
     return flag;
 }
@@ -46,22 +234,46 @@ flag_t *flag_init(const bool state, const char *yes, const char* no)
 /* Deallocates memory */
 void flag_destroy(flag_t *flag)
 {
-    free(flag->yes);
-    free(flag->no);
+    pthread_mutex_lock(&flag_lock);
+    flag_registry[flag->id] = NULL;
+    if (flag->id < flag_free) {
+        flag_free = flag->id;
+    }
+    flag_text_put(flag->yes);
+    flag_text_put(flag->no);
+    pthread_mutex_unlock(&flag_lock);
+
     free(flag);
 }
 
 
+/* Gets a registered flag by its identifier */
+flag_t *flag_get(uint32_t id)
+{
+    flag_t *flag;
+
+    if (id >= FLAG_MAX) {
+        return NULL;
+    }
+    pthread_mutex_lock(&flag_lock);
+    flag = flag_registry[id];
+    pthread_mutex_unlock(&flag_lock);
+
+    return flag;
+}
+
+
 /* Compares two flags */
 bool flag_cmp(const flag_t *f1, const flag_t *f2, bool statecmp)
 {
-    if (statecmp) {
-        if (f1->state != f2->state) {
-            return false;
-        }
+    if (!f1 || !f2) {
+        return f1 == f2;
+    }
+    if (statecmp && f1->initial != f2->initial) {
+        return false;
     }
 
-    return (strncmp(f1->yes, f2->yes, strlen(f1->yes)) == 0) &&
-           (strncmp(f1->no, f2->no, strlen(f1->no)) == 0);
+    /* Equal texts are the same string of the pool */
+    return f1->yes == f2->yes && f1->no == f2->no;
 }
 
@@ -15,15 +15,171 @@
  * @file inventory.c
  *
  * @brief Inventory related functions implementation
+ *
+ * The index is kept at most half full, and removing from it shifts
+ * back the entries that follow in the same run, so there are no
+ * tombstones.  The identifiers of items start at 1, so 0 marks an
+ * empty entry.
+ *
+ * The bulk operations take the items out of the source leaving holes,
+ * and close them once at the end, so keeping the order costs a single
+ * pass instead of one per item.
+ *
+ * Every time an item goes in or out of an inventory, the store is told
+ * where the item is.
  */
 
 /* System includes */
 #include <stdbool.h>    /* bool, true, false */
-#include <stdlib.h>     /* malloc, realloc, free */
+#include <stdint.h>     /* uint32_t */
+#include <stdlib.h>     /* malloc, calloc, realloc, free */
+#include <string.h>     /* memmove, memset */
 
 /* Local includes */
 #include <item.h>
 #include <inventory.h>
+#include <store.h>
+
+#define INV_MIN_CAP  (8)    /**< Initial capacity of the array */
+
+
+/* Entry of the index where an id should be */
+static inline size_t inv_hash(const inv_t *inv, uint32_t id)
+{
+    uint32_t h = id * 2654435769u;
+
+    return (h ^ (h >> 16)) & (inv->index_cap - 1);
+}
+
+
+/* Entry of the index of an id, or the empty entry where it would be */
+static size_t inv_index_find(const inv_t *inv, uint32_t id)
+{
+    size_t pos = inv_hash(inv, id);
+
+    while (inv->index[pos].id && inv->index[pos].id != id) {
+        pos = (pos + 1) & (inv->index_cap - 1);
+    }
+
+    return pos;
+}
+
+
+/* Removes the entry of an id from the index */
+static void inv_index_rem(inv_t *inv, size_t pos)
+{
+    size_t mask = inv->index_cap - 1;
+
+    for (size_t next = (pos + 1) & mask; inv->index[next].id;
+            next = (next + 1) & mask) {
+        size_t home = inv_hash(inv, inv->index[next].id);
+        if (((next - home) & mask) >= ((next - pos) & mask)) {
+            inv->index[pos] = inv->index[next];
+            pos = next;
+        }
+    }
+    inv->index[pos].id = 0;
+}
+
+
+/* Makes room for at least 'len' items */
+static bool inv_reserve(inv_t *inv, size_t len)
+{
+    item_t **items;
+    inv_slot_t *index;
+    size_t cap = inv->cap ? inv->cap : INV_MIN_CAP;
+
+    if (len <= inv->cap) {
+        return true;
+    }
+    if (len > UINT32_MAX) {
+        return false;
+    }
+    while (cap < len) {
+        cap *= 2;
+    }
+
+    if (!(items = realloc(inv->items, sizeof(item_t *) * cap))) {
+        return false;
+    }
+    inv->items = items;
+    if (!(index = calloc(cap * 2, sizeof(inv_slot_t)))) {
+        return false;
+    }
+    free(inv->index);
+    inv->index = index;
+    inv->index_cap = cap * 2;
+    inv->cap = cap;
+
+    for (size_t i = 0; i < inv->len; ++i) {
+        size_t pos = inv_index_find(inv, inv->items[i]->id);
+        inv->index[pos].id = inv->items[i]->id;
+        inv->index[pos].pos = i;
+    }
+
+    return true;
+}
+
+
+/* Puts an item at the end, once there's room and it's not there */
+static void inv_link(inv_t *inv, item_t *item)
+{
+    size_t pos = inv_index_find(inv, item->id);
+
+    inv->index[pos].id = item->id;
+    inv->index[pos].pos = inv->len;
+    inv->items[inv->len] = item;
+    inv->len++;
+    store_set_owner(item->id, inv);
+}
+
+
+/* Tells the store that an item is no longer in an inventory */
+static inline void inv_disown(const inv_t *inv, const item_t *item)
+{
+    if (store_owner(item->id) == inv) {
+        store_set_owner(item->id, NULL);
+    }
+}
+
+
+/* Takes out the item of an entry of the index, leaving a hole (NULL),
+ * or putting the last item in its place */
+static void inv_unlink(inv_t *inv, size_t entry, bool hole)
+{
+    size_t i = inv->index[entry].pos;
+
+    inv_disown(inv, inv->items[i]);
+    inv_index_rem(inv, entry);
+    if (hole) {
+        inv->items[i] = NULL;
+        return;
+    }
+    if (i != inv->len - 1) {
+        inv->items[i] = inv->items[inv->len - 1];
+        inv->index[inv_index_find(inv, inv->items[i]->id)].pos = i;
+    }
+    inv->len--;
+}
+
+
+/* Closes the holes left by 'inv_unlink', keeping the order */
+static void inv_compact(inv_t *inv)
+{
+    size_t len = 0;
+
+    for (size_t i = 0; i < inv->len; ++i) {
+        if (!inv->items[i]) {
+            continue;
+        }
+        if (i != len) {
+            inv->items[len] = inv->items[i];
+            inv->index[inv_index_find(inv, inv->items[len]->id)].pos = len;
+        }
+        len++;
+    }
+    inv->len = len;
+}
 
 
 /* Initializes a new empty inventory */
@@ -35,12 +191,12 @@ inv_t *inv_init(void)
         return NULL;
     }
 
-    if (!(inv->items = malloc(sizeof(item_t *)))) {
-        return NULL;
-    }
-
+    inv->items = NULL;
     inv->len = 0;
-    inv->weight = 0.0f;
+    inv->cap = 0;
+    inv->index = NULL;
+    inv->index_cap = 0;
+    inv->weight = 0;
 
     return inv;
 }
@@ -49,12 +205,15 @@ inv_t *inv_init(void)
 /* Frees allocated memory */
 void inv_destroy(inv_t *inv, bool destroy_items)
 {
-    if (inv->items && destroy_items) {
-        for (size_t i = 0; i < inv->len; ++i) {
+    for (size_t i = 0; i < inv->len; ++i) {
+        if (destroy_items) {
             item_destroy(inv->items[i]);
+        } else {
+            inv_disown(inv, inv->items[i]);
         }
     }
     free(inv->items);
+    free(inv->index);
     free(inv);
 }
 
@@ -62,34 +221,23 @@ void inv_destroy(inv_t *inv, bool destroy_items)
 /* Checks if an item is contained in a specific inventory */
 bool inv_has_item(inv_t *inv, item_t *item)
 {
-    if (!item || !inv) {
+    if (!item || !inv || inv->len == 0) {
         return false;
     }
-    
-    for (size_t i = 0; i < inv->len; ++i) {
-        if (inv->items[i]->id == item->id) {
-            return true;
-        }
-    }
 
-    return false;
+    return inv->index[inv_index_find(inv, item->id)].id == item->id;
 }
 
 
 /* Adds an item to the inventory */
 bool inv_add(inv_t *inv, item_t *item)
 {
-    if (!item || !inv || inv_has_item(inv, item)) {
-        return false;
-    }
-
-    inv->items = realloc(inv->items, sizeof(item_t *) * (inv->len + 1));
-    if (!inv->items) {
+    if (!item || !inv || item->id == 0 || inv_has_item(inv, item) ||
+            !inv_reserve(inv, inv->len + 1)) {
         return false;
     }
 
-    inv->items[inv->len] = item;
-    inv->len++;
+    inv_link(inv, item);
     inv->weight += item->weight;
 
     return true;
@@ -97,41 +245,162 @@ bool inv_add(inv_t *inv, item_t *item)
 
 
 /* Removes an item from the inventory */
-bool inv_rem(inv_t *inv, item_t *item)
+bool inv_remove(inv_t *inv, item_t *item, bool stable)
 {
-    if (!item || !inv || !inv_has_item(inv, item) || inv->len == 0) {
+    size_t entry;
+    size_t i;
+
+    if (!item || !inv || inv->len == 0) {
+        return false;
+    }
+    entry = inv_index_find(inv, item->id);
+    if (inv->index[entry].id != item->id) {
         return false;
     }
+    if (!stable) {
+        inv_unlink(inv, entry, false);
+        inv->weight -= item->weight;
+        return true;
+    }
 
-    for (size_t i = 0; i < inv->len; ++i) {
-        if (inv->items[i]->id == item->id) {
-            for (size_t j = i; j < inv->len; ++j) {
-                inv->items[j] = inv->items[j + 1];
-            }
-            inv->items = realloc(inv->items, sizeof(item_t *) * inv->len);
-            if (!inv->items) {
-                return false;
-            }
-            inv->len--;
-            inv->weight -= item->weight;
-        }
+    i = inv->index[entry].pos;
+    inv_disown(inv, item);
+    inv_index_rem(inv, entry);
+    memmove(&inv->items[i], &inv->items[i + 1],
+            sizeof(item_t *) * (inv->len - i - 1));
+    for (size_t j = i; j < inv->len - 1; ++j) {
+        inv->index[inv_index_find(inv, inv->items[j]->id)].pos = j;
     }
+    inv->len--;
+    inv->weight -= item->weight;
 
     return true;
 }
 
 
 /* Moves an item from one inventory to another */
-bool inv_transfer(inv_t *src, inv_t *dest, item_t *item)
+bool inv_move(inv_t *src, inv_t *dest, item_t *item, bool stable)
 {
-    return inv_rem(src, item) && inv_add(dest, item);
+    if (!inv_has_item(src, item) || !dest || inv_has_item(dest, item) ||
+            !inv_reserve(dest, dest->len + 1)) {
+        return false;
+    }
+
+    return inv_remove(src, item, stable) && inv_add(dest, item);
 }
 
 
-/* Calculates the effective weight of the inventory */
-float inv_eval_weight(inv_t *inv)
+/* Moves several items from one inventory to another */
+size_t inv_move_many(inv_t *src, inv_t *dest, item_t **items, size_t n,
+                     bool stable)
 {
-    float total_weight = 0.0f;
+    weight_t weight = 0;
+    size_t moved = 0;
+
+    if (!src || !dest || src == dest || !items || src->len == 0 ||
+            !inv_reserve(dest, dest->len + (n < src->len ? n : src->len))) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t entry;
+
+        if (!items[i] || inv_has_item(dest, items[i])) {
+            continue;
+        }
+        entry = inv_index_find(src, items[i]->id);
+        if (src->index[entry].id != items[i]->id) {
+            continue;   /* not there, or already moved */
+        }
+        inv_unlink(src, entry, stable);
+        inv_link(dest, items[i]);
+        weight += items[i]->weight;
+        moved++;
+    }
+    if (stable && moved > 0) {
+        inv_compact(src);
+    }
+    src->weight -= weight;
+    dest->weight += weight;
+
+    return moved;
+}
+
+
+/* Moves every item that meets a condition to another inventory */
+size_t inv_move_if(inv_t *src, inv_t *dest, inv_pred_t pred, void *data)
+{
+    uint64_t *chosen;
+    weight_t weight = 0;
+    size_t moved = 0;
+
+    if (!src || !dest || src == dest || !pred || src->len == 0 ||
+            !(chosen = calloc((src->len + 63) / 64, sizeof(uint64_t)))) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < src->len; ++i) {
+        if (pred(src->items[i], data) && !inv_has_item(dest, src->items[i])) {
+            chosen[i / 64] |= UINT64_C(1) << (i % 64);
+            moved++;
+        }
+    }
+    if (moved == 0 || !inv_reserve(dest, dest->len + moved)) {
+        free(chosen);
+        return 0;
+    }
+
+    for (size_t i = 0; i < src->len; ++i) {
+        if (chosen[i / 64] & (UINT64_C(1) << (i % 64))) {
+            item_t *item = src->items[i];
+            inv_unlink(src, inv_index_find(src, item->id), true);
+            inv_link(dest, item);
+            weight += item->weight;
+        }
+    }
+    inv_compact(src);
+    src->weight -= weight;
+    dest->weight += weight;
+    free(chosen);
+
+    return moved;
+}
+
+
+/* Moves every item from one inventory to another */
+size_t inv_clear_into(inv_t *src, inv_t *dest)
+{
+    weight_t weight = 0;
+    size_t moved = 0;
+
+    if (!src || !dest || src == dest || src->len == 0 ||
+            !inv_reserve(dest, dest->len + src->len)) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < src->len; ++i) {
+        if (!inv_has_item(dest, src->items[i])) {
+            inv_link(dest, src->items[i]);
+            weight += src->items[i]->weight;
+            moved++;
+        } else if (store_owner(src->items[i]->id) == src) {
+            store_set_owner(src->items[i]->id, dest);
+        }
+    }
+    dest->weight += weight;
+
+    memset(src->index, 0, sizeof(inv_slot_t) * src->index_cap);
+    src->len = 0;
+    src->weight = 0;
+
+    return moved;
+}
+
+
+/* Calculates the effective weight of the inventory, in grams */
+weight_t inv_eval_weight_g(inv_t *inv)
+{
+    weight_t total_weight = 0;
 
     if (inv) {
         for (size_t i = 0; i < inv->len; ++i) {
@@ -141,4 +410,3 @@ float inv_eval_weight(inv_t *inv)
 
     return total_weight;
 }
-
@@ -15,25 +15,109 @@
  * @file item.c
  *
  * @brief Item routines implementation
+ *
+ * An item and its lingo structure are a single block taken from a
+ * slab, so creating an item takes only the allocation of its strings,
+ * and the parts of an item are next to each other.  The qualities of
+ * the item are in the store.
+ *
+ * The nouns and adjectives of every item are also in two inverted
+ * indices, updated along with the sets of words of the items.
  */
 
 /* System includes*/
+#include <pthread.h>    /* pthread_mutex_* */
 #include <stdint.h> /* int32_t */
 #include <stdlib.h> /* malloc, free */
 
 /* Local includes */
+#include <inventory.h>
 #include <item.h>
 #include <lingo.h>
 #include <qltys.h>
+#include <slab.h>
+#include <store.h>
 #include <strops.h>
+#include <widx.h>
+#include <wset.h>
+
+#define ITEM_SLAB_BLOCK  (256)  /**< Items allocated at once */
+
+
+/* Item with its parts */
+typedef struct {
+    item_t item;    /* must be the first */
+    lingo_t lingo;
+} item_block_t;
+
+/* Word to remove from an index */
+typedef struct {
+    widx_t *widx;
+    uint32_t id;
+} item_unindex_t;
+
+
+static slab_t item_slab = SLAB_INIT(sizeof(item_block_t), ITEM_SLAB_BLOCK);
+static widx_t item_nouns = WIDX_INIT;   /**< Items by noun */
+static widx_t item_adjs = WIDX_INIT;    /**< Items by adjective */
+static pthread_mutex_t item_widx_lock = PTHREAD_MUTEX_INITIALIZER;
 
 
-static uint32_t item_last_id = 0;   /**< Item unique identifier */
+/* Adds a word to a set of an item, and to its index */
+static bool item_word_add(item_t *item, wset_t *wset, widx_t *widx,
+                          const char *word)
+{
+    atom_t atom;
+    bool added;
+
+    if (!item || !word || str_is_empty(word) ||
+            !wset_add_atom(wset, atom = atom_intern_str(word))) {
+        return false;
+    }
+
+    pthread_mutex_lock(&item_widx_lock);
+    added = widx_add(widx, atom, item->id);
+    pthread_mutex_unlock(&item_widx_lock);
+    if (!added) {
+        wset_rem_atom(wset, atom);
+    }
+
+    return added;
+}
+
+
+/* Removes a word from a set of an item, and from its index */
+static bool item_word_rem(item_t *item, wset_t *wset, widx_t *widx,
+                          const char *word)
+{
+    atom_t atom;
+
+    if (!item || !word || str_is_empty(word) ||
+            !wset_rem_atom(wset, atom = atom_find_str(word))) {
+        return false;
+    }
+
+    pthread_mutex_lock(&item_widx_lock);
+    widx_rem(widx, atom, item->id);
+    pthread_mutex_unlock(&item_widx_lock);
+
+    return true;
+}
+
+
+/* Removes a word of an item from an index */
+static void item_unindex(atom_t atom, void *data)
+{
+    item_unindex_t *word = data;
+
+    widx_rem(word->widx, atom, word->id);
+}
 
 
 /* Allocates memory for a new item */
 item_t *item_init(const char *name, const char *desc, float weight)
 {
+    item_block_t *block;
     item_t *item;
 
     /* Item name is a requirement */
@@ -41,20 +125,23 @@ item_t *item_init(const char *name, const char *desc, float weight)
         return NULL;
     }
 
-    if (!(item = malloc(sizeof(item_t)))) {
+    if (!(block = slab_alloc(&item_slab))) {
         return NULL;
     }
 
-    if (!(item->lingo = lingo_init_kdo(name, desc))) {
+    if (!lingo_init_at(&block->lingo, name, NULL, desc, true)) {
+        slab_free(&item_slab, block);
         return NULL;
     }
 
-    if (!(item->qltys = qltys_init())) {
+    item = &block->item;
+    item->lingo = &block->lingo;
+    item->weight = weight_from_kg(weight);
+    if (!store_add(item)) {
+        lingo_destroy_at(&block->lingo);
+        slab_free(&item_slab, block);
         return NULL;
     }
-    
-    item->weight = weight;
-    item->id = item_next_id;
 
     return item;
 }
@@ -63,8 +150,102 @@ item_t *item_init(const char *name, const char *desc, float weight)
 /* Frees allocated memory */
 void item_destroy(item_t *item)
 {
-    lingo_destroy_soft(item->lingo);
-    qltys_destroy_hard(item->qltys);
-    free(item);
+    inv_t *owner = store_owner(item->id);
+
+    /* The identifier is given again, so no inventory can keep it */
+    if (owner) {
+        inv_remove(owner, item, true);
+    }
+
+    pthread_mutex_lock(&item_widx_lock);
+    wset_each(&item->lingo->nouns, item_unindex,
+              &(item_unindex_t) { &item_nouns, item->id });
+    wset_each(&item->lingo->adjs, item_unindex,
+              &(item_unindex_t) { &item_adjs, item->id });
+    pthread_mutex_unlock(&item_widx_lock);
+
+    store_rem(item);
+    lingo_destroy_at(item->lingo);
+    slab_free(&item_slab, item);
+}
+
+
+/* Changes the weight of an item */
+bool item_set_weight(item_t *item, float weight)
+{
+    return item && store_set_weight(item->id, weight_from_kg(weight));
+}
+
+
+/* Adds a noun to the item */
+bool item_add_noun(item_t *item, const char *noun)
+{
+    return item && item_word_add(item, &item->lingo->nouns, &item_nouns,
+                                 noun);
+}
+
+
+/* Removes a noun from the item */
+bool item_rem_noun(item_t *item, const char *noun)
+{
+    return item && item_word_rem(item, &item->lingo->nouns, &item_nouns,
+                                 noun);
 }
 
+
+/* Adds an adjective to the item */
+bool item_add_adj(item_t *item, const char *adj)
+{
+    return item && item_word_add(item, &item->lingo->adjs, &item_adjs, adj);
+}
+
+
+/* Removes an adjective from the item */
+bool item_rem_adj(item_t *item, const char *adj)
+{
+    return item && item_word_rem(item, &item->lingo->adjs, &item_adjs, adj);
+}
+
+
+/* Finds the items that have a noun and an adjective */
+size_t item_find(atom_t noun, atom_t adj, item_t **items, size_t max)
+{
+    const uint32_t *nouns;
+    const uint32_t *adjs;
+    const uint32_t *ids;
+    uint32_t *both = NULL;
+    size_t n_nouns;
+    size_t n_adjs;
+    size_t len;
+
+    if (noun == ATOM_NONE && adj == ATOM_NONE) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&item_widx_lock);
+    nouns = widx_get(&item_nouns, noun, &n_nouns);
+    adjs = widx_get(&item_adjs, adj, &n_adjs);
+    if (noun == ATOM_NONE) {
+        ids = adjs;
+        len = n_adjs;
+    } else if (adj == ATOM_NONE) {
+        ids = nouns;
+        len = n_nouns;
+    } else if (n_nouns == 0 || n_adjs == 0 ||
+            !(both = malloc(sizeof(uint32_t) *
+                            (n_nouns < n_adjs ? n_nouns : n_adjs)))) {
+        ids = NULL;
+        len = 0;
+    } else {
+        ids = both;
+        len = widx_intersect(nouns, n_nouns, adjs, n_adjs, both);
+    }
+
+    for (size_t i = 0; items && i < len && i < max; ++i) {
+        items[i] = store_get(ids[i]);
+    }
+    pthread_mutex_unlock(&item_widx_lock);
+    free(both);
+
+    return len;
+}
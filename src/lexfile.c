@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file lexfile.c
+ *
+ * @brief Binary lexicon files implementation
+ *
+ * When loading, the header and the sizes of the sections are checked
+ * first, and then every index stored in the tables is checked once,
+ * so a file damaged or not written by @e lexfile_save can't make the
+ * lookups read out of the mapping.
+ */
+
+/* System includes */
+#include <fcntl.h>      /* open */
+#include <stdbool.h>    /* bool, true, false */
+#include <stdint.h>     /* uint32_t, uint64_t */
+#include <stdio.h>      /* fopen, fwrite, fclose */
+#include <stdlib.h>     /* calloc, free */
+#include <string.h>     /* memcmp, memcpy */
+#include <sys/mman.h>   /* mmap, munmap */
+#include <sys/stat.h>   /* fstat */
+#include <unistd.h>     /* close */
+
+/* Local includes */
+#include <lexfile.h>
+#include <lexicon.h>
+#include <tokenizer.h>
+
+
+/* Checks that every index in the tables is within its table */
+static bool lexfile_check(const lexicon_t *lexicon,
+                          const tokenizer_t *tokenizer)
+{
+    size_t ntrans = tokenizer->nstates * tokenizer->nclasses;
+
+    for (size_t i = 0; i < lexicon->len; ++i) {
+        const lexentry_t *entry = &lexicon->entries[i];
+        if (entry->off > lexicon->pool_len ||
+                entry->len > lexicon->pool_len - entry->off) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < lexicon->nslots; ++i) {
+        if (lexicon->slots[i] > lexicon->len) {         /* entry + 1 */
+            return false;
+        }
+    }
+    for (size_t i = 0; i < 256; ++i) {
+        if (tokenizer->classes[i] >= tokenizer->nclasses) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < ntrans; ++i) {
+        if (tokenizer->trans[i] >= tokenizer->nstates) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < tokenizer->nstates; ++i) {
+        if (tokenizer->accept[i] > lexicon->len) {      /* entry + 1 */
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/* Maps a lexicon file in memory */
+lexfile_t *lexfile_load(const char *path)
+{
+    lexfile_t *lexfile;
+    const lexfile_header_t *header;
+    struct stat st;
+    char *p;
+    uint64_t size;
+    int fd;
+
+    if (!path || (fd = open(path, O_RDONLY)) < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(*header) ||
+            !(lexfile = calloc(1, sizeof(lexfile_t)))) {
+        close(fd);
+        return NULL;
+    }
+    lexfile->size = st.st_size;
+    lexfile->map = mmap(NULL, lexfile->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (lexfile->map == MAP_FAILED) {
+        free(lexfile);
+        return NULL;
+    }
+
+    /* Check the header and the size of every section */
+    header = lexfile->map;
+    size = sizeof(*header) +
+           (uint64_t) header->len * sizeof(lexentry_t) +
+           (uint64_t) header->nbuckets * sizeof(uint32_t) +
+           (uint64_t) header->nslots * sizeof(uint32_t) +
+           256 +
+           (uint64_t) header->nstates * header->nclasses * sizeof(uint32_t) +
+           (uint64_t) header->nstates * sizeof(uint32_t) +
+           header->pool_len;
+    if (memcmp(header->magic, LEXFILE_MAGIC, sizeof(header->magic)) != 0 ||
+            header->version != LEXFILE_VERSION || size != lexfile->size ||
+            header->nbuckets == 0 || header->nslots == 0 ||
+            (header->nslots & (header->nslots - 1)) != 0 ||
+            header->nclasses == 0 || header->nstates < 2) {
+        lexfile_destroy(lexfile);
+        return NULL;
+    }
+
+    /* Point every table to its section */
+    p = (char *) lexfile->map + sizeof(*header);
+    lexfile->lexicon.len = header->len;
+    lexfile->lexicon.entries = (lexentry_t *) p;
+    p += header->len * sizeof(lexentry_t);
+    lexfile->lexicon.nbuckets = header->nbuckets;
+    lexfile->lexicon.disp = (uint32_t *) p;
+    p += header->nbuckets * sizeof(uint32_t);
+    lexfile->lexicon.nslots = header->nslots;
+    lexfile->lexicon.slots = (uint32_t *) p;
+    p += header->nslots * sizeof(uint32_t);
+    lexfile->lexicon.seed = header->seed;
+
+    memcpy(lexfile->tokenizer.classes, p, 256);
+    p += 256;
+    tokenizer_init_delims(&lexfile->tokenizer);
+    lexfile->tokenizer.lexicon = &lexfile->lexicon;
+    lexfile->tokenizer.nclasses = header->nclasses;
+    lexfile->tokenizer.nstates = header->nstates;
+    lexfile->tokenizer.trans = (uint32_t *) p;
+    p += (size_t) header->nstates * header->nclasses * sizeof(uint32_t);
+    lexfile->tokenizer.accept = (uint32_t *) p;
+    p += header->nstates * sizeof(uint32_t);
+
+    lexfile->lexicon.pool = p;
+    lexfile->lexicon.pool_len = header->pool_len;
+
+    if (!lexfile_check(&lexfile->lexicon, &lexfile->tokenizer)) {
+        lexfile_destroy(lexfile);
+        return NULL;
+    }
+
+    return lexfile;
+}
+
+
+/* Unmaps a lexicon file */
+void lexfile_destroy(lexfile_t *lexfile)
+{
+    munmap(lexfile->map, lexfile->size);
+    free(lexfile);
+}
+
+
+/* Writes a lexicon and its tokenizer to a file */
+bool lexfile_save(const char *path, const lexicon_t *lexicon,
+                  const tokenizer_t *tokenizer)
+{
+    lexfile_header_t header = { .version = LEXFILE_VERSION };
+    FILE *fp;
+    bool written;
+
+    if (!path || !lexicon || !tokenizer || !lexicon->slots ||
+            tokenizer->lexicon != lexicon ||
+            !(fp = fopen(path, "wb"))) {
+        return false;
+    }
+
+    memcpy(header.magic, LEXFILE_MAGIC, sizeof(header.magic));
+    header.len = lexicon->len;
+    header.nbuckets = lexicon->nbuckets;
+    header.nslots = lexicon->nslots;
+    header.seed = lexicon->seed;
+    header.nclasses = tokenizer->nclasses;
+    header.nstates = tokenizer->nstates;
+    header.pool_len = (lexicon->pool_len + 3) & ~(size_t) 3;
+
+    written =
+        fwrite(&header, sizeof(header), 1, fp) == 1 &&
+        fwrite(lexicon->entries, sizeof(lexentry_t), lexicon->len, fp)
+            == lexicon->len &&
+        fwrite(lexicon->disp, sizeof(uint32_t), lexicon->nbuckets, fp)
+            == lexicon->nbuckets &&
+        fwrite(lexicon->slots, sizeof(uint32_t), lexicon->nslots, fp)
+            == lexicon->nslots &&
+        fwrite(tokenizer->classes, 1, 256, fp) == 256 &&
+        fwrite(tokenizer->trans, sizeof(uint32_t) * tokenizer->nclasses,
+               tokenizer->nstates, fp) == tokenizer->nstates &&
+        fwrite(tokenizer->accept, sizeof(uint32_t), tokenizer->nstates, fp)
+            == tokenizer->nstates &&
+        fwrite(lexicon->pool, 1, lexicon->pool_len, fp)
+            == lexicon->pool_len &&
+        fwrite("\0\0\0", 1, header.pool_len - lexicon->pool_len, fp)
+            == header.pool_len - lexicon->pool_len;
+
+    return (fclose(fp) == 0) && written;
+}
@@ -0,0 +1,445 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file lexicon.c
+ *
+ * @brief Lexicon implementation using a perfect hash function
+ *
+ * The perfect hash is built by "hash and displace": every word falls in
+ * a bucket (about four words per bucket), and for every bucket, from the
+ * biggest to the smallest, a displacement is searched so all the words
+ * in the bucket land on free slots of the table.  Since the table has
+ * at least twice the slots than words, the search is short.
+ *
+ * To look up a word, the bucket gives the displacement, and the
+ * displacement gives the only slot where the word may be.
+ *
+ * A text lexicon has a line for every category, with its name and its
+ * words, separated by blanks; @e data/lexicon.txt is the one built in.
+ */
+
+/* System includes */
+#include <stdbool.h>    /* bool, true, false */
+#include <stdint.h>     /* uint32_t, uint64_t */
+#include <stdlib.h>     /* malloc, calloc, realloc, free, qsort */
+#include <string.h>     /* memchr, memcmp, memcpy, strlen, strncmp */
+
+/* Local includes */
+#include <array.h>
+#include <lexicon.h>
+#include <strops.h>
+
+#define LEXICON_BLANKS  " \t\r"  /**< Separators of a text lexicon */
+
+
+/* Lexeme type by name of the category, in a text lexicon */
+static const struct {
+    const char *name;
+    lexeme_t lex;
+} lexicon_categories[] = {
+    { "verb", LEX_VERB },
+    { "adverb", LEX_ADVERB },
+    { "article", LEX_ART },
+    { "adjective", LEX_ADJ },
+    { "number", LEX_NUM },
+    { "noun", LEX_NOUN },
+    { "preposition", LEX_PREP },
+    { "pronoun", LEX_PRONOUN },
+    { "conjunction", LEX_CONJ },
+};
+
+#define LEXICON_BUCKET_SIZE  (4)        /**< Average words per bucket */
+#define LEXICON_MAX_DISP     (1 << 16)  /**< Displacements to try */
+#define LEXICON_MAX_SEEDS    (32)       /**< Seeds to try */
+
+
+/* Mixes the bits of a 64 bit hash value (MurmurHash3 finalizer) */
+static inline uint64_t lexicon_mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+
+/* Hashes a word (FNV-1a) */
+static inline uint64_t lexicon_hash(const char *word, size_t len,
+                                    uint32_t seed)
+{
+    uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char) word[i];
+        h *= 0x100000001b3ULL;
+    }
+
+    return lexicon_mix(h);
+}
+
+
+/* Slot of a word in the table given its hash and a displacement */
+static inline size_t lexicon_slot(const lexicon_t *lexicon, uint64_t h,
+                                  uint32_t d)
+{
+    uint32_t f1 = (uint32_t) (h >> 32);
+    uint32_t f2 = (uint32_t) lexicon_mix(h ^ 0x9e3779b97f4a7c15ULL) | 1;
+
+    return (f1 + d * f2) & (lexicon->nslots - 1);
+}
+
+
+/* Bucket of a word given its hash */
+#define lexicon_bucket(l, h)  ((uint32_t) (h) % (l)->nbuckets)
+
+
+/* Creates an empty lexicon */
+lexicon_t *lexicon_init(void)
+{
+    lexicon_t *lexicon;
+
+    if (!(lexicon = calloc(1, sizeof(lexicon_t)))) {
+        return NULL;
+    }
+
+    return lexicon;
+}
+
+
+/* Frees allocated memory */
+void lexicon_destroy(lexicon_t *lexicon)
+{
+    free(lexicon->entries);
+    free(lexicon->pool);
+    free(lexicon->disp);
+    free(lexicon->slots);
+    free(lexicon);
+}
+
+
+/* Adds a word, not necessarily null-terminated, to the lexicon */
+static bool lexicon_add_len(lexicon_t *lexicon, const char *word,
+                            size_t len, lexeme_t lex)
+{
+    void *p;
+
+    if (len == 0 || len > UINT16_MAX) {
+        return false;
+    }
+
+    if (lexicon->len == lexicon->cap) {
+        size_t cap = lexicon->cap ? lexicon->cap * 2 : 64;
+        if (!(p = realloc(lexicon->entries, sizeof(lexentry_t) * cap))) {
+            return false;
+        }
+        lexicon->entries = p;
+        lexicon->cap = cap;
+    }
+
+    if (lexicon->pool_len + len + 1 > lexicon->pool_cap) {
+        size_t cap = lexicon->pool_cap ? lexicon->pool_cap * 2 : 512;
+        while (lexicon->pool_len + len + 1 > cap) {
+            cap *= 2;
+        }
+        if (!(p = realloc(lexicon->pool, cap))) {
+            return false;
+        }
+        lexicon->pool = p;
+        lexicon->pool_cap = cap;
+    }
+
+    memcpy(lexicon->pool + lexicon->pool_len, word, len);
+    lexicon->pool[lexicon->pool_len + len] = '\0';
+    lexicon->entries[lexicon->len].off = lexicon->pool_len;
+    lexicon->entries[lexicon->len].len = len;
+    lexicon->entries[lexicon->len].lex = lex;
+    lexicon->pool_len += len + 1;
+    lexicon->len++;
+
+    return true;
+}
+
+
+/* Adds a word to the lexicon */
+bool lexicon_add(lexicon_t *lexicon, const char *word, lexeme_t lex)
+{
+    return lexicon && word && lexicon_add_len(lexicon, word, strlen(word), lex);
+}
+
+
+/* Lexeme type of the name of a category, LEX_UNK if there's none */
+static lexeme_t lexicon_category(const span_t *name)
+{
+    for (size_t i = 0; i < arr_len(lexicon_categories); ++i) {
+        if (strlen(lexicon_categories[i].name) == name->len &&
+                strncmp(name->s, lexicon_categories[i].name,
+                        name->len) == 0) {
+            return lexicon_categories[i].lex;
+        }
+    }
+
+    return LEX_UNK;
+}
+
+
+/* Adds the words of a text lexicon */
+size_t lexicon_read(lexicon_t *lexicon, const char *text, size_t len)
+{
+    const char *end = text + len;
+    size_t lineno = 0;
+    charset_t blanks;
+
+    if (!lexicon || !text) {
+        return 1;
+    }
+
+    charset_init(&blanks, LEXICON_BLANKS, sizeof(LEXICON_BLANKS) - 1);
+    for (const char *line = text; line < end; ) {
+        const char *eol = memchr(line, '\n', end - line);
+        str_iter_t it = str_iter(line, (eol ? eol : end) - line, &blanks);
+        span_t word;
+        lexeme_t lex;
+
+        ++lineno;
+        line = eol ? eol + 1 : end;
+        if (!str_iter_next(&it, &word) || word.s[0] == '#') {
+            continue;
+        }
+        if ((lex = lexicon_category(&word)) == LEX_UNK) {
+            return lineno;
+        }
+        while (str_iter_next(&it, &word)) {
+            if (!lexicon_add_len(lexicon, word.s, word.len, lex)) {
+                return lineno;
+            }
+        }
+    }
+
+    return 0;
+}
+
+
+/* Checks if an entry has the same word */
+static inline bool lexicon_entry_is(const lexicon_t *lexicon,
+                                    const lexentry_t *entry,
+                                    const char *word, size_t len)
+{
+    return entry->len == len &&
+           memcmp(lexicon_word(lexicon, entry), word, len) == 0;
+}
+
+
+/* Removes repeated words, keeping the first one of each */
+static bool lexicon_unique(lexicon_t *lexicon)
+{
+    size_t size = 1;
+    size_t kept = 0;
+    uint32_t *seen;
+
+    while (size < lexicon->len * 2) {
+        size <<= 1;
+    }
+    if (!(seen = calloc(size, sizeof(uint32_t)))) {
+        return false;
+    }
+
+    for (size_t i = 0; i < lexicon->len; ++i) {
+        lexentry_t *entry = &lexicon->entries[i];
+        const char *word = lexicon_word(lexicon, entry);
+        size_t pos = lexicon_hash(word, entry->len, 0) & (size - 1);
+        bool repeated = false;
+
+        while (seen[pos]) {
+            if (lexicon_entry_is(lexicon, &lexicon->entries[seen[pos] - 1],
+                                 word, entry->len)) {
+                repeated = true;
+                break;
+            }
+            pos = (pos + 1) & (size - 1);
+        }
+        if (!repeated) {
+            lexicon->entries[kept] = *entry;
+            seen[pos] = ++kept;
+        }
+    }
+    lexicon->len = kept;
+
+    free(seen);
+
+    return true;
+}
+
+
+/* Bucket with the entries that fall on it, to sort them by size */
+typedef struct {
+    uint32_t bucket;
+    uint32_t first;     /* Index in the array of entries by bucket */
+    uint32_t len;
+} lexbucket_t;
+
+
+/* Sorts buckets, biggest first */
+static int lexicon_bucket_cmp(const void *a, const void *b)
+{
+    const lexbucket_t *ba = a;
+    const lexbucket_t *bb = b;
+
+    if (ba->len != bb->len) {
+        return ba->len < bb->len ? 1 : -1;
+    }
+
+    return ba->bucket < bb->bucket ? -1 : ba->bucket > bb->bucket;
+}
+
+
+/* Tries to build the table with a specific seed */
+static bool lexicon_place(lexicon_t *lexicon, uint64_t *hashes,
+                          uint32_t *order, lexbucket_t *buckets,
+                          size_t *used)
+{
+    size_t k;
+
+    memset(lexicon->slots, 0, sizeof(uint32_t) * lexicon->nslots);
+    memset(buckets, 0, sizeof(lexbucket_t) * lexicon->nbuckets);
+
+    /* Counting sort of the entries by bucket */
+    for (size_t i = 0; i < lexicon->len; ++i) {
+        hashes[i] = lexicon_hash(lexicon_word(lexicon, &lexicon->entries[i]),
+                                 lexicon->entries[i].len, lexicon->seed);
+        buckets[lexicon_bucket(lexicon, hashes[i])].len++;
+    }
+    k = 0;
+    for (size_t b = 0; b < lexicon->nbuckets; ++b) {
+        buckets[b].bucket = b;
+        buckets[b].first = k;
+        k += buckets[b].len;
+        buckets[b].len = 0;
+    }
+    for (size_t i = 0; i < lexicon->len; ++i) {
+        lexbucket_t *bucket = &buckets[lexicon_bucket(lexicon, hashes[i])];
+        order[bucket->first + bucket->len++] = i;
+    }
+    qsort(buckets, lexicon->nbuckets, sizeof(lexbucket_t),
+          lexicon_bucket_cmp);
+
+    /* Displace every bucket until all its entries are on free slots */
+    for (size_t b = 0; b < lexicon->nbuckets && buckets[b].len; ++b) {
+        lexbucket_t *bucket = &buckets[b];
+        uint32_t d;
+
+        for (d = 0; d < LEXICON_MAX_DISP; ++d) {
+            for (k = 0; k < bucket->len; ++k) {
+                size_t slot = lexicon_slot(lexicon,
+                                           hashes[order[bucket->first + k]],
+                                           d);
+                if (lexicon->slots[slot]) {
+                    break;
+                }
+                lexicon->slots[slot] = order[bucket->first + k] + 1;
+                used[k] = slot;
+            }
+            if (k == bucket->len) {
+                break;
+            }
+            while (k--) {   /* undo */
+                lexicon->slots[used[k]] = 0;
+            }
+        }
+        if (d == LEXICON_MAX_DISP) {
+            return false;
+        }
+        lexicon->disp[bucket->bucket] = d;
+    }
+
+    return true;
+}
+
+
+/* Computes the perfect hash table */
+bool lexicon_build(lexicon_t *lexicon)
+{
+    uint64_t *hashes = NULL;
+    uint32_t *order = NULL;
+    lexbucket_t *buckets = NULL;
+    size_t *used = NULL;
+    bool built = false;
+
+    if (!lexicon || !lexicon_unique(lexicon)) {
+        return false;
+    }
+
+    free(lexicon->disp);
+    free(lexicon->slots);
+    lexicon->nbuckets = lexicon->len / LEXICON_BUCKET_SIZE + 1;
+    lexicon->nslots = 2;
+    while (lexicon->nslots < lexicon->len * 2) {
+        lexicon->nslots <<= 1;
+    }
+    lexicon->disp = calloc(lexicon->nbuckets, sizeof(uint32_t));
+    lexicon->slots = calloc(lexicon->nslots, sizeof(uint32_t));
+
+    if (lexicon->disp && lexicon->slots &&
+            (hashes = malloc(sizeof(uint64_t) * (lexicon->len + 1))) &&
+            (order = malloc(sizeof(uint32_t) * (lexicon->len + 1))) &&
+            (buckets = malloc(sizeof(lexbucket_t) * lexicon->nbuckets)) &&
+            (used = malloc(sizeof(size_t) * (lexicon->len + 1)))) {
+        for (uint32_t s = 0; s < LEXICON_MAX_SEEDS && !built; ++s) {
+            lexicon->seed = s;
+            built = lexicon_place(lexicon, hashes, order, buckets, used);
+        }
+    }
+
+    free(hashes);
+    free(order);
+    free(buckets);
+    free(used);
+
+    return built;
+}
+
+
+/* Looks up a word in the lexicon */
+const lexentry_t *lexicon_find(const lexicon_t *lexicon,
+                               const char *word, size_t len)
+{
+    uint64_t h;
+    uint32_t idx;
+
+    if (!lexicon->slots || len == 0) {
+        return NULL;
+    }
+
+    h = lexicon_hash(word, len, lexicon->seed);
+    idx = lexicon->slots[lexicon_slot(lexicon, h,
+                         lexicon->disp[lexicon_bucket(lexicon, h)])];
+
+    if (idx && lexicon_entry_is(lexicon, &lexicon->entries[idx - 1],
+                                word, len)) {
+        return &lexicon->entries[idx - 1];
+    }
+
+    return NULL;
+}
+
+
+/* Returns the lexeme type of a word */
+lexeme_t lexicon_type(const lexicon_t *lexicon, const char *word, size_t len)
+{
+    const lexentry_t *entry = lexicon_find(lexicon, word, len);
+
+    return entry ? (lexeme_t) entry->lex : LEX_UNK;
+}
@@ -20,14 +20,65 @@
 /* System includes */
 #include <stdbool.h>    /* bool */
 #include <stdlib.h>     /* malloc, free */
-#include <string.h>     /* strlen */
+#include <string.h>     /* memcpy, strlen */
 
 /* Local includes */
 #include <lingo.h>
-#include <strops.h>
 #include <wset.h>
 
 
+/* Copies a string at the end of the text, if there's a string */
+static char *lingo_text_cpy(char **end, const char *s, size_t len)
+{
+    char *copy = *end;
+
+    if (!s) {
+        return NULL;
+    }
+    memcpy(copy, s, len + 1);
+    *end += len + 1;
+
+    return copy;
+}
+
+
+/* Initializes a structure already allocated */
+bool lingo_init_at(lingo_t *lingo, const char *kname, const char *uname,
+                   const char *desc, bool direct)
+{
+    size_t klen = kname ? strlen(kname) : 0;
+    size_t ulen = uname ? strlen(uname) : 0;
+    size_t dlen = desc ? strlen(desc) : 0;
+    char *end;
+
+    if (!(lingo->text = malloc(klen + ulen + dlen + 3))) {
+        return false;
+    }
+    end = lingo->text;
+    lingo->kname = lingo_text_cpy(&end, kname, klen);
+    lingo->uname = lingo_text_cpy(&end, uname, ulen);
+    lingo->desc = lingo_text_cpy(&end, desc, dlen);
+    wset_init_at(&lingo->nouns);
+    wset_init_at(&lingo->adjs);
+    wset_init_at(&lingo->pronouns);
+
+    lingo->direct = direct;
+
+    return true;
+}
+
+
+/* Frees the memory used by a structure, but not the structure */
+void lingo_destroy_at(lingo_t *lingo)
+{
+    wset_destroy_at(&lingo->nouns);
+    wset_destroy_at(&lingo->adjs);
+    wset_destroy_at(&lingo->pronouns);
+
+    free(lingo->text);
+}
+
+
 /* Initializes the structure */
 lingo_t *lingo_init(const char *kname, const char *uname,
                     const char *desc, bool direct)
@@ -38,14 +89,10 @@ lingo_t *lingo_init(const char *kname, const char *uname,
         return NULL;
     }
 
-    lingo->uname = str_alloc_cpy(uname);
-    lingo->kname = str_alloc_cpy(kname);
-    lingo->desc = str_alloc_cpy(desc);
-    lingo->nouns = wset_init();
-    lingo->adjs = wset_init();
-    lingo->pronouns = wset_init();
-
-    lingo->direct = direct;
+    if (!lingo_init_at(lingo, kname, uname, desc, direct)) {
+        free(lingo);
+        return NULL;
+    }
 
     return lingo;
 }
@@ -54,14 +101,7 @@ lingo_t *lingo_init(const char *kname, const char *uname,
 /* Frees allocated memory */
 void lingo_destroy(lingo_t *lingo, bool destroy_sets)
 {
-    wset_destroy(lingo->nouns, destroy_sets);
-    wset_destroy(lingo->adjs, destroy_sets);
-    wset_destroy(lingo->pronouns, destroy_sets);
-
-    free(lingo->desc);
-    free(lingo->kname);
-    free(lingo->uname);
-
+    (void) destroy_sets;
+    lingo_destroy_at(lingo);
     free(lingo);
 }
-
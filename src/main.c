@@ -1,22 +1,157 @@
 /* Command and parsing test */
 #ifdef DEBUG
-    #include <stdio.h>
     #include <mcheck.h>
     #include <malloc.h>
 #endif
 
+#include <ctype.h>
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
 #include <input.h>
 #include <parser.h>
-#include <strops.h>
+#include <printer.h>
+#include <replay.h>
+#include <server.h>
+#include <turn.h>
 
-#define CMD_PROMPT   " > "
 #define CMD_MAX_LEN  (80)
 
 
+/* Shows how to use the program */
+static void usage(FILE *fp, const char *name)
+{
+    fprintf(fp, "Usage: %s [OPTION]...\n", name);
+    fprintf(fp, "  -l, --lexicon FILE  use the lexicon compiled in FILE\n");
+    fprintf(fp, "  -r, --replay FILE   play every line of FILE and report\n");
+    fprintf(fp, "  -s, --server PATH   serve players on the socket PATH\n");
+    fprintf(fp, "  -t, --threads N     serve with N threads (default: "
+                "one per core)\n");
+    fprintf(fp, "  -h, --help          show this help and exit\n");
+}
+
+
+/* Reads the number of threads, from 1 to SERVER_THREADS_MAX */
+static bool read_threads(const char *s, unsigned *nthreads)
+{
+    unsigned long n;
+    char *end;
+
+    if (!isdigit((unsigned char) *s)) {
+        return false;   /* strtoul would take spaces and signs */
+    }
+    errno = 0;
+    n = strtoul(s, &end, 10);
+    if (errno != 0 || *end != '\0' || n == 0 || n > SERVER_THREADS_MAX) {
+        return false;
+    }
+    *nthreads = (unsigned) n;
+
+    return true;
+}
+
+
+/* Stops the server on SIGINT and SIGTERM */
+static void on_signal(int sig)
+{
+    (void) sig;
+    server_stop();
+}
+
+
+/* Serves players until interrupted */
+static int serve(const char *path, unsigned nthreads)
+{
+    struct sigaction sa = { .sa_handler = on_signal };
+
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    return server_run(path, nthreads);
+}
+
+
+/* Plays a transcript and shows how long it took */
+static int replay(const char *path)
+{
+    replay_stats_t stats;
+    double secs;
+    int ret_val;
+
+    if ((ret_val = replay_file(path, &stats)) != 0) {
+        return ret_val;
+    }
+    secs = stats.ns / 1e9;
+    printf("lines: %zu\n", stats.lines);
+    printf("time: %.6f s (%.0f lines/s)\n", secs,
+           secs > 0 ? stats.lines / secs : 0.0);
+    printf("output: %zu bytes\n", stats.bytes);
+    printf("commands: digest %016" PRIx64 "\n", stats.digest);
+
+    return 0;
+}
+
+
 /* Main entry */
-int main(void)
+int main(int argc, char *argv[])
 {
+    static const struct option options[] = {
+        { "lexicon", required_argument, NULL, 'l' },
+        { "replay", required_argument, NULL, 'r' },
+        { "server", required_argument, NULL, 's' },
+        { "threads", required_argument, NULL, 't' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 },
+    };
+    const char *lexicon = NULL;
+    const char *transcript = NULL;
+    const char *server = NULL;
+    unsigned nthreads = 0;
+    printer_t *out;
+    turn_t turn;
     char cmd[CMD_MAX_LEN];
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "l:r:s:t:h", options, NULL)) != -1) {
+        switch (opt) {
+            case 'l':
+                lexicon = optarg;
+                break;
+
+            case 'r':
+                transcript = optarg;
+                break;
+
+            case 's':
+                server = optarg;
+                break;
+
+            case 't':
+                if (!read_threads(optarg, &nthreads)) {
+                    fprintf(stderr, "%s: the number of threads must be "
+                            "from 1 to %d\n", argv[0], SERVER_THREADS_MAX);
+                    usage(stderr, argv[0]);
+                    return 1;
+                }
+                break;
+
+            case 'h':
+                usage(stdout, argv[0]);
+                return 0;
+
+            default:
+                usage(stderr, argv[0]);
+                return 1;
+        }
+    }
 
 #ifdef DEBUG
     puts(" *** DEBUG MODE ON ***");
@@ -25,11 +160,42 @@ int main(void)
     mtrace();
 #endif
 
+    if ((lexicon ? parser_load(lexicon) : parser_init()) != 0) {
+        fprintf(stderr, "%s: can't load the lexicon\n", argv[0]);
+        return 1;
+    }
+    if (transcript) {
+        int ret_val = replay(transcript);
+        if (ret_val == 2) {
+            perror(transcript);
+        }
+        parser_destroy();
+        return ret_val;
+    }
+    if (server) {
+        int ret_val = serve(server, nthreads);
+        if (ret_val != 0) {
+            perror(server);
+        }
+        parser_destroy();
+        return ret_val;
+    }
+    if (!(out = printer_init_fd(STDOUT_FILENO))) {
+        parser_destroy();
+        return 1;
+    }
+    turn_init_at(&turn, out);
+
     do {
-        get_line(CMD_PROMPT, cmd, CMD_MAX_LEN);
-        parse(cmd);
-    } while (!streq(cmd, "quit"));
+        printer_flush(out);
+        if (get_line(TURN_PROMPT, cmd, CMD_MAX_LEN) == 1) {
+            break;  /* no more input */
+        }
+        turn_line(&turn, cmd, strlen(cmd));
+    } while (!turn.quit);
+
+    printer_destroy(out);
+    parser_destroy();
 
     return 0;
 }
-
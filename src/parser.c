@@ -18,52 +18,41 @@
  *
  * It identifies every token with a gramatic value after applying rules
  * (language dependant) to exclude plurals, conjugations, prefixation,
- * etc.  The function in charge of this is `str_in_array`, that compares
- * the token with a database of words classified by synxtax category.
+ * etc.  The words classified by synxtax category are stored in a
+ * lexicon, that finds the category of any token with a single probe.
  *
  * There's a priority order in case a word could have different
  * syntactic values.  Instead of checking the sourroundings, the value
- * of the word is assigned just as it goes the analysis in
- * `lexeme_type`.
+ * of the word is assigned by the order in which the categories are
+ * added to the lexicon in `parser_init`.
  */
 
 /* System includes */
 #include <ctype.h>  /* tolower */
-#include <stdlib.h> /* free, malloc */
-#include <string.h> /* strlen, strndup, strsep, strstr */
+#include <string.h> /* strlen */
 
 #ifdef DEBUG
     #include <stdio.h>
 #endif
 
 /* Local includes */
-#include <array.h>
+#include <arena.h>
+#include <atom.h>
 #include <cmd.h>
+#include <lexfile.h>
+#include <lexicon.h>
+#include <printer.h>
 #include <strops.h>
+#include <tmpl.h>
+#include <tokenizer.h>
 #include <parser.h>
 
 
-/* Arrays of valid words separated by lexeme type.
- * TODO: later, taken from data files or databases */
-static const char *adverbs[] =
-    { "gently", "softly", "viciously", };
-static const char *adjectives[] =
-    { "red", "blue", "green", "yellow", "white", "black", "silver", };
-static const char *numbers[] =
-    { "one", "two", "three", "four", "five", "1", "2", "3", };
-static const char *articles[] =
-    { "a", "an", "the", };
-static const char *conjunctions[] =
-    { "and", "then", };
-static const char *nouns[] =
-    { "dog", "cat", "birds", "mouse", "potion", "key", "lock", };
-static const char *pronouns[] =
-    { "him", "her", "his", "its", "self", };
-static const char *prepositions[] =
-    { "about", "to", "for", "at", "in", "on", "of", "with", "from", };
-static const char *verbs[] =
-    { "ask", "give", "run", "fly", "put", "eat", "drink", "catch",
-      "take", "drop", "open", };
+/* Words of every category, taken from 'data/lexicon.txt' when building.
+ * These are used unless a lexicon file is loaded with 'parser_load' */
+static const char words[] =
+#include <lexicon.inc>
+    ;
 
 /*
 static const char *answers[] =
@@ -84,18 +73,80 @@ static const char *commands[] =
  */
 
 
-/* Gets the lexeme */
-lexeme_t lexeme_type(const char *word)
+static lexicon_t *lexicon = NULL;     /**< Every word above, by category */
+static tokenizer_t *tokenizer = NULL; /**< Automaton for the lexicon */
+static lexfile_t *lexfile = NULL;     /**< Lexicon file, if loaded */
+/* Every thread handles its own turns, so these are not shared */
+static _Thread_local arena_t *turn = NULL;    /**< Memory of the turn */
+static _Thread_local printer_t *out = NULL;   /**< Where messages go */
+static _Thread_local parser_cmd_cb_t observer = NULL; /**< Told of commands */
+static _Thread_local void *observer_data = NULL;    /**< Data of observer */
+
+
+#ifdef DEBUG
+/* Messages, compiled once */
+static tmpl_t *msg_cmd = NULL;      /**< Words of a command */
+static tmpl_t *msg_unknown = NULL;  /**< Word not understood */
+static tmpl_t *msg_dropped = NULL;  /**< Commands not done */
+
+
+/* Compiles the messages */
+static int parser_msgs_init(void)
 {
-    if (!word) {
-        return LEX_END;
+    if (!msg_cmd) {
+        msg_cmd = tmpl_init("Action?....... {action}\n"
+                            "Mode?......... {mode}\n"
+                            "Quantity?..... {number}\n"
+                            "Quality?...... {quality}\n"
+                            "D.Object?..... {dobj}\n"
+                            "I.Object?..... {iobj}\n");
+        msg_unknown = tmpl_init("I don't understand '{unknown}'.");
+        msg_dropped = tmpl_init("Too many commands; only the first {qty} "
+                                "were done.");
+    }
+
+    return msg_cmd && msg_unknown && msg_dropped ? 0 : 1;
+}
+
+
+/* Frees the messages */
+static void parser_msgs_destroy(void)
+{
+    tmpl_destroy(msg_cmd);
+    tmpl_destroy(msg_unknown);
+    tmpl_destroy(msg_dropped);
+    msg_cmd = msg_unknown = msg_dropped = NULL;
+}
+
+
+/* Prints a message with the printer, or to 'stdout' if there's none */
+static void parser_print(const tmpl_t *tmpl, const tmpl_args_t *args)
+{
+    printer_t *mem;
+
+    if (out) {
+        pt(out, tmpl, args);
+    } else if ((mem = printer_init_mem())) {
+        pt(mem, tmpl, args);
+        fputs(printer_data(mem, NULL), stdout);
+        printer_destroy(mem);
     }
+}
+#else
+    #define parser_msgs_init()     (0)
+    #define parser_msgs_destroy()  ((void) 0)
+#endif
 
-    /* Here the priority is set indirectly by the order how these
-     * conditionals are processed.  For a S-V-O model, the pronoun
-     * should go first, but in these kind of adventures it's used more
-     * the imperative, more like V-O, where the pronouns are part of the
-     * object, who also may have adjectives.  Numbers as adjectives are
+
+/* Builds the lexicon */
+int parser_init(void)
+{
+    /* Here the priority is set indirectly by the order of the
+     * categories in the lexicon, since the first one wins when a word
+     * is repeated.  For a S-V-O model, the pronoun should go first, but
+     * in these kind of adventures it's used more the imperative, more
+     * like V-O, where the pronouns are part of the object, who also may
+     * have adjectives.  Numbers as adjectives are
      * parsed separately, so it'll be easier to disaggregate them and
      * convert them to proper integers.
      *
@@ -119,51 +170,143 @@ lexeme_t lexeme_type(const char *word)
      *      ---- ---------- ---------
      *      Act.   D.O.       I.O.
      */
+    if (lexicon) {
+        return 0;
+    }
+
+    if (!(lexicon = lexicon_init())) {
+        return 1;
+    }
+
+    if (lexicon_read(lexicon, words, sizeof(words) - 1) != 0 ||
+            !lexicon_build(lexicon) ||
+            !(tokenizer = tokenizer_init(lexicon, DELIMITERS)) ||
+            atom_init(lexicon) != 0 || parser_msgs_init() != 0) {
+        parser_destroy();
+        return 1;
+    }
+
+    return 0;
+}
+
+
+/* Uses the lexicon of a file */
+int parser_load(const char *path)
+{
+    lexfile_t *loaded;
+
+    /* The atoms already given are words of the lexicon in use */
+    if (atom_in_use() || !(loaded = lexfile_load(path))) {
+        return 1;
+    }
+
+    parser_destroy();
+    lexfile = loaded;
+    lexicon = &lexfile->lexicon;
+    tokenizer = &lexfile->tokenizer;
+
+    return atom_init(lexicon) != 0 || parser_msgs_init() != 0;
+}
+
+
+/* Frees the lexicon */
+void parser_destroy(void)
+{
+    parser_free_turn();
+    parser_msgs_destroy();
+    atom_destroy();
+    if (lexfile) {
+        lexfile_destroy(lexfile);
+        lexfile = NULL;
+    } else {
+        if (tokenizer) {
+            tokenizer_destroy(tokenizer);
+        }
+        if (lexicon) {
+            lexicon_destroy(lexicon);
+        }
+    }
+    tokenizer = NULL;
+    lexicon = NULL;
+}
+
+
+/* Gets the lexicon of the parser */
+const lexicon_t *parser_lexicon(void)
+{
+    return lexicon;
+}
+
+
+/* Sets where the messages go */
+void parser_set_printer(printer_t *printer)
+{
+    out = printer;
+}
+
+
+/* Sets the function told of every command parsed */
+void parser_set_observer(parser_cmd_cb_t cb, void *data)
+{
+    observer = cb;
+    observer_data = data;
+}
+
+
+/* Gets the memory of the current turn */
+arena_t *parser_turn(void)
+{
+    if (!turn) {
+        turn = arena_init(ARENA_CHUNK);
+    }
+
+    return turn;
+}
+
+
+/* Ends the turn, freeing its memory */
+void parser_end_turn(void)
+{
+    if (turn) {
+        arena_reset(turn);
+    }
+}
+
+
+/* Frees the memory of the turns of the calling thread */
+void parser_free_turn(void)
+{
+    arena_destroy(turn);
+    turn = NULL;
+}
+
+
+/* Gets the lexeme */
+lexeme_t lexeme_type(const char *word)
+{
+    if (!word || (!lexicon && parser_init() != 0)) {
+        return LEX_END;
+    }
+
     if (str_is_empty(word)) {
         return LEX_EMPTY;
-    } else if (str_in_array(word, verbs, darr_len_str(verbs))) {
-        return LEX_VERB;
-    } else if (str_in_array(word, adverbs, darr_len_str(adverbs))) {
-        return LEX_ADVERB;
-    } else if (str_in_array(word, articles, darr_len_str(articles))) {
-        return LEX_ART;
-    } else if (str_in_array(word, adjectives, darr_len_str(adjectives))) {
-        return LEX_ADJ;
-    } else if (str_in_array(word, numbers, darr_len_str(numbers))) {
-        return LEX_NUM;
-    } else if (str_in_array(word, nouns, darr_len_str(nouns))) {
-        return LEX_NOUN;
-    } else
-        if (str_in_array(word, prepositions, darr_len_str(prepositions))) {
-        return LEX_PREP;
-    } else if (str_in_array(word, pronouns, darr_len_str(pronouns))) {
-        return LEX_PRONOUN;
-    } else
-        if (str_in_array(word, conjunctions, darr_len_str(conjunctions))) {
-        return LEX_CONJ;
     }
 
-    return LEX_UNK;
+    return lexicon_type(lexicon, word, strlen(word));
 }
 
 
 /* Parse syntax of previously analyzed sentence chunks */
-int parse_cmd(cmd_t *cmd)
+int parse_cmd(const cmdv_t *cmd)
 {
-    if (!cmd_action) { /* no verb, no action, therefore nothing to do */
+    if (!cmd_action.atom) { /* no verb, no action, therefore nothing to do */
         return 1;
     }
 
     /* Command processing */
 /**/
 #ifdef DEBUG
-    printf("Action?....... %s\n", cmd_action);
-    printf("Mode?......... %s\n", cmd_mode);
-    printf("Quantity?..... %s\n", cmd_quantity);
-    printf("Quality?...... %s\n", cmd_quality);
-    printf("D.Object?..... %s\n", cmd_dobj);
-    printf("I.Object?..... %s\n", cmd_iobj);
-    puts("");
+    parser_print(msg_cmd, &(tmpl_args_t) { .cmd = cmd });
 #endif
 /**/
 
@@ -171,133 +314,175 @@ int parse_cmd(cmd_t *cmd)
 }
 
 
-/* Parse sentence */
-int parse_simple(char *sentence)
+/* Places a word in its part of the command */
+static void parse_token(cmdv_t *cmd, const token_t *token)
 {
-    lexeme_t token_type;
-    char *token;
-    cmd_t *cmd;
-    bool valid = true;
+    /* is_direction (n, nw...)?, is_special (look...)?,
+     * is_system (load...)?, is_answer (yes, no...)?,
+     * is_management (inventory...)? is_...*/
+    switch (token->lex) {
+        case LEX_VERB:
+            cmd_action = (cword_t) { token->span, token->entry };
+            break;
+
+        case LEX_ADVERB:
+            cmd_mode = (cword_t) { token->span, token->entry };
+            break;
+
+        case LEX_PREP:
+            break;
+
+        case LEX_ART:
+            break;
+
+        case LEX_NUM:
+            cmd_quantity = (cword_t) { token->span, token->entry };
+            break;
+
+        case LEX_ADJ:
+            cmd_quality = (cword_t) { token->span, token->entry };
+            break;
+
+        case LEX_NOUN:
+            cmd_dobj = (cword_t) { token->span, token->entry };
+            break;
+
+        case LEX_PRONOUN:
+            cmd_iobj = (cword_t) { token->span, token->entry };
+            break;
+
+        case LEX_CONJ:
+            break;
+
+        case LEX_UNK:
+        default:
+            if (!cmd->unknown.len) {
+                cmd->unknown = token->span;
+            }
+            break;
+    }
+}
+
 
-    if (!(cmd = cmd_init_empty())) {
+/* Parses the command if every word was understood */
+static int parse_valid_cmd(const cmdv_t *cmd)
+{
+    if (!cmdv_is_valid(cmd)) {
+#ifdef DEBUG
+        parser_print(msg_unknown, &(tmpl_args_t) { .cmd = cmd });
+#endif
         return 1;
     }
 
-    while ((token = strsep(&sentence, DELIMITERS))) {
-        token_type = lexeme_type(token);
-            /* is_direction (n, nw...)?, is_special (look...)?,
-             * is_system (load...)?, is_answer (yes, no...)?,
-             * is_management (inventory...)? is_...*/
+    parse_cmd(cmd);
+
+    return 0;
+}
+
 
-        switch (token_type) {
-            case LEX_VERB:
-                cmd_action = str_alloc_cpy(token);
-                break;
+/* Parse sentence */
+int parse_simple(char *sentence)
+{
+    const char *cursor = sentence;
+    const char *end;
+    token_t token;
+    cmdv_t cmd;
 
-            case LEX_ADVERB:
-                cmd_mode = str_alloc_cpy(token);
-                break;
+    if (!sentence || (!tokenizer && parser_init() != 0)) {
+        return 2;
+    }
 
-            case LEX_PREP:
-                break;
+    cmdv_clear(&cmd);
+    end = sentence + strlen(sentence);
+    while (tokenizer_next(tokenizer, &cursor, end, &token)) {
+        parse_token(&cmd, &token);
+    }
+    parse_valid_cmd(&cmd);
 
-            case LEX_ART:
-                break;
+    return 0;
+}
 
-            case LEX_NUM:
-                cmd_quantity = str_alloc_cpy(token);
-                break;
 
-            case LEX_ADJ:
-                cmd_quality = str_alloc_cpy(token);
-                break;
+/* Splits a compound sentence in commands */
+size_t parse_line(const char *line, size_t len, cmdlist_t *list)
+{
+    const char *cursor = line;
+    token_t token;
+    cmdv_t *cmd = NULL;    /* Command being filled, if any */
 
-            case LEX_NOUN:
-                cmd_dobj = str_alloc_cpy(token);
-                break;
+    list->len = 0;
+    list->overflow = false;
 
-            case LEX_PRONOUN:
-                cmd_iobj = str_alloc_cpy(token);
-                break;
+    if (!line || (!tokenizer && parser_init() != 0)) {
+        return 0;
+    }
 
-            case LEX_CONJ:
-                break;
+    while (tokenizer_next(tokenizer, &cursor, line + len, &token)) {
+        if (token.lex == LEX_CONJ) {
+            if (cmd) {  /* close the command */
+                list->len++;
+                cmd = NULL;
+            }
+            continue;
+        }
 
-            case LEX_UNK:
-#ifdef DEBUG
-                printf("I don't understand '%s'.\n", token);
-#endif
-                valid = false;
-                break;
-
-            case LEX_EMPTY:
-                valid = false;
-                break;
-
-            case LEX_END:   /* This point is reached on error */
-            default:
-                valid = false;
-                cmd_destroy(cmd);
-                return 2;
+        if (!cmd) {     /* open a new command */
+            if (list->len == CMD_LIST_MAX) {
+                list->overflow = true;
+                return list->len;
+            }
+            cmd = &list->cmds[list->len];
+            cmdv_clear(cmd);
         }
+        parse_token(cmd, &token);
     }
 
-    if (valid) {
-        parse_cmd(cmd);
+    if (cmd) {
+        list->len++;
     }
-    cmd_destroy(cmd);
 
-    return 0;
+    return list->len;
 }
 
 
-/* Parse several sentences connected by a copulative lexeme */
-/* FIXME: It has to be another method better for this -> refactor!
- * (may be that amount of pointers are not needed, also, not that many
- * calls to 'str_trim') */
-int parse_compound(char *sentence)
+/* Parses several sentences already normalized */
+int parse_normalized(const char *sentence, size_t len)
 {
-    char *first;
-    char *last;
-    char *prev;
-    char *next;
-    int ret_val = 0;
-    int it = 0; /* iterations := (# of commands in sentence) - 1 */
-
-    if (!sentence || str_is_empty(sentence)) {
-        ret_val = -1;
-        parse_simple(sentence);
-    }
+    cmdlist_t list;
+    int failed = 0;
 
-    /* Iterate over all subsentences */
-    str_normalize_l(&sentence);
-    first = sentence;
-    while ((next = strstr(first, SEPARATOR))) {
-        prev = first;
-        first = strndup(next + strlen(SEPARATOR),
-                        strlen(next) - strlen(SEPARATOR));
-        last = strndup(prev, strlen(prev) - strlen(next));
-        str_trim(last);
-        ret_val += parse_simple(last);
-        it++;
+    if (!sentence || len == 0) {
+        return -1;
     }
 
-    /* Iterate over the last remaining sentence, or the only one if no
-     * separator */
-    if (it) {
-        str_trim(first);
-        ret_val += parse_simple(first);
-        /* Those strings are created by 'strndup' and I think they may
-         * be deallocated with 'free'. */
-        free(first);
-        free(last);
-    } else {
-        ret_val = parse_simple(sentence);
+    parse_line(sentence, len, &list);
+    for (size_t i = 0; i < list.len; ++i) {
+        int ret_val = parse_valid_cmd(&list.cmds[i]);
+        if (observer) {
+            observer(&list.cmds[i], ret_val, observer_data);
+        }
+        failed += ret_val;
+    }
+    if (list.overflow) {
+#ifdef DEBUG
+        parser_print(msg_dropped, &(tmpl_args_t) { .qty = CMD_LIST_MAX });
+#endif
+        failed++;   /* the commands dropped */
     }
 
-    /* QUESTION:
-     * Return instead the number of iterations, `it`, (menaning, the
-     * number of successfully parsed sentences)? */
-    return ret_val;
+    return failed;
 }
 
+
+/* Parse several sentences connected by a copulative lexeme */
+int parse_compound(char *sentence)
+{
+    size_t len;
+
+    if (!sentence) {
+        return -1;
+    }
+    len = str_normalize_l(&sentence);
+
+    return parse_normalized(sentence, len);
+}
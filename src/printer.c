@@ -15,52 +15,310 @@
  * @file printer.c
  *
  * @brief Priting routines implementation
+ *
+ * The buffer is always null-terminated, so the output can be given as
+ * a string without copying it.
  */
 
 /* System includes */
-#include <stdlib.h>
+#include <errno.h>      /* errno, EINTR */
+#include <stdarg.h>     /* va_list, va_start, va_copy, va_end */
+#include <stdio.h>      /* vsnprintf */
+#include <stdlib.h>     /* malloc, realloc, free */
+#include <string.h>     /* memcpy, strlen */
+#include <unistd.h>     /* write */
 
 /* Local includes */
 #include <flag.h>
 #include <printer.h>
+#include <qltys.h>
+
+#define PRINTER_MIN_CAP  (256)  /**< Initial size of the buffer */
+
+
+/* Adapts a function of 'printer_init' to a sink function, that is
+ * given the output without its last end of line, as 'puts' adds it */
+static int printer_print_cb(const char *s, size_t len, void *data)
+{
+    printer_t *printer = data;
+
+    if (len > 0 && s[len - 1] == '\n') {
+        printer->buf[len - 1] = '\0';
+    }
 
+    return printer->print(s);
+}
 
-/*  */
+
+/* Creates a printer with an empty buffer */
+static printer_t *printer_new(printer_sink_t sink)
+{
+    printer_t *printer;
+
+    if (!(printer = malloc(sizeof(printer_t)))) {
+        return NULL;
+    }
+    if (!(printer->buf = malloc(PRINTER_MIN_CAP))) {
+        free(printer);
+        return NULL;
+    }
+    printer->buf[0] = '\0';
+    printer->len = 0;
+    printer->cap = PRINTER_MIN_CAP;
+    printer->sink = sink;
+    printer->fd = -1;
+    printer->cb = NULL;
+    printer->data = NULL;
+    printer->print = NULL;
+
+    return printer;
+}
+
+
+/* Makes room for 'len' more bytes and the null */
+static bool printer_reserve(printer_t *printer, size_t len)
+{
+    size_t cap = printer->cap;
+    char *buf;
+
+    if (printer->len + len < printer->cap) {
+        return true;
+    }
+    while (printer->len + len >= cap) {
+        cap *= 2;
+    }
+    if (!(buf = realloc(printer->buf, cap))) {
+        return false;
+    }
+    printer->buf = buf;
+    printer->cap = cap;
+
+    return true;
+}
+
+
+/* Flushes when the buffer is big enough */
+static int printer_check(printer_t *printer, int added)
+{
+    if (printer->sink != PRINTER_MEM && printer->len >= PRINTER_FLUSH_AT &&
+            printer_flush(printer) < 0) {
+        return -1;
+    }
+
+    return added;
+}
+
+
+/* Initializes printer "object" with a function taking a string */
 printer_t *printer_init(int (*print)(const char *))
 {
     printer_t *printer;
 
-    if (!print) {
+    if (!print || !(printer = printer_init_cb(printer_print_cb, NULL))) {
         return NULL;
     }
+    printer->data = printer;
+    printer->print = print;
 
-    if (!(printer = malloc(sizeof(printer_t)))) {
+    return printer;
+}
+
+
+/* Initializes a printer that writes to a file descriptor */
+printer_t *printer_init_fd(int fd)
+{
+    printer_t *printer;
+
+    if (fd < 0 || !(printer = printer_new(PRINTER_FD))) {
         return NULL;
     }
+    printer->fd = fd;
 
-    printer->print = print;
+    return printer;
+}
+
+
+/* Initializes a printer that keeps its output in memory */
+printer_t *printer_init_mem(void)
+{
+    return printer_new(PRINTER_MEM);
+}
+
+
+/* Initializes a printer that sends its output to a function */
+printer_t *printer_init_cb(printer_cb_t cb, void *data)
+{
+    printer_t *printer;
+
+    if (!cb || !(printer = printer_new(PRINTER_CB))) {
+        return NULL;
+    }
+    printer->cb = cb;
+    printer->data = data;
 
     return printer;
 }
 
 
+/* Frees allocated memory */
 void printer_destroy(printer_t *printer)
 {
+    if (!printer) {
+        return;
+    }
+    printer_flush(printer);
+    free(printer->buf);
     free(printer);
 }
 
 
-/* Prints information depending on the status of the flag */
-int printer_flag(printer_t *printer, flag_t *flag)
+/* Adds text to the output */
+int printer_write(printer_t *printer, const char *s, size_t len)
 {
-    if (!flag->yes || !flag->no) {
+    if (!printer_reserve(printer, len)) {
+        return -1;
+    }
+    memcpy(printer->buf + printer->len, s, len);
+    printer->len += len;
+    printer->buf[printer->len] = '\0';
+
+    return printer_check(printer, (int) len);
+}
+
+
+/* Adds a line to the output */
+int printer_puts(printer_t *printer, const char *s)
+{
+    size_t len = strlen(s);
+
+    if (!printer_reserve(printer, len + 1)) {
+        return -1;
+    }
+    memcpy(printer->buf + printer->len, s, len);
+    printer->buf[printer->len + len] = '\n';
+    printer->len += len + 1;
+    printer->buf[printer->len] = '\0';
+
+    return printer_check(printer, (int) len + 1);
+}
+
+
+/* Adds formatted text to the output, from a list of arguments */
+int printer_vprintf(printer_t *printer, const char *fmt, va_list args)
+{
+    va_list again;
+    int len;
+
+    va_copy(again, args);
+    len = vsnprintf(printer->buf + printer->len,
+                    printer->cap - printer->len, fmt, args);
+    if (len < 0) {
+        va_end(again);
+        printer->buf[printer->len] = '\0';
+        return -1;
+    }
+
+    /* Didn't fit, so try again with room enough */
+    if ((size_t) len >= printer->cap - printer->len) {
+        if (!printer_reserve(printer, len)) {
+            printer->buf[printer->len] = '\0';
+            va_end(again);
+            return -1;
+        }
+        vsnprintf(printer->buf + printer->len, printer->cap - printer->len,
+                  fmt, again);
+    }
+    va_end(again);
+    printer->len += len;
+
+    return printer_check(printer, len);
+}
+
+
+/* Adds formatted text to the output */
+int printer_printf(printer_t *printer, const char *fmt, ...)
+{
+    va_list args;
+    int len;
+
+    va_start(args, fmt);
+    len = printer_vprintf(printer, fmt, args);
+    va_end(args);
+
+    return len;
+}
+
+
+/* Delivers the output to the sink */
+int printer_flush(printer_t *printer)
+{
+    size_t done = 0;
+    int ret_val = 0;
+
+    if (!printer || printer->len == 0 || printer->sink == PRINTER_MEM) {
         return 0;
     }
 
-    if (flag->state) {
-        return printer->print(flag->yes);
+    if (printer->sink == PRINTER_CB) {
+        ret_val = printer->cb(printer->buf, printer->len, printer->data) < 0 ?
+                  -1 : 0;
     } else {
-        return printer->print(flag->no);
+        while (done < printer->len) {
+            ssize_t n = write(printer->fd, printer->buf + done,
+                              printer->len - done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0) {
+                ret_val = -1;
+                break;
+            }
+            done += n;
+        }
+    }
+    printer_clear(printer);
+
+    return ret_val;
+}
+
+
+/* Gets the output kept by a printer */
+const char *printer_data(const printer_t *printer, size_t *len)
+{
+    if (len) {
+        *len = printer->len;
+    }
+
+    return printer->buf;
+}
+
+
+/* Discards the output kept by a printer */
+void printer_clear(printer_t *printer)
+{
+    printer->len = 0;
+    printer->buf[0] = '\0';
+}
+
+
+/* Prints information depending on a state of the flag */
+int printer_flag(printer_t *printer, const flag_t *flag, bool state)
+{
+    if (!flag || !flag->yes || !flag->no) {
+        return 0;
     }
+
+    return printer_puts(printer, state ? flag->yes : flag->no);
 }
 
+
+/* Prints information depending on the state of the flag in a set */
+int printer_qlty(printer_t *printer, const qltys_t *qltys,
+                 const flag_t *flag)
+{
+    if (!qltys_has_flag(qltys, flag)) {
+        return 0;
+    }
+
+    return printer_flag(printer, flag, qltys_state(qltys, flag));
+}
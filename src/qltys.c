@@ -15,122 +15,137 @@
  * @file qltys.c
  *
  *
- * @brief Flag array implementation
+ * @brief Flag set implementation
+ *
+ * The bit of a flag is always off in @e state when the flag is not in
+ * @e has, so a pattern can be matched word by word.
  */
 
 /* System includes */
 #include <stdbool.h>    /* bool, true, false */
-#include <stdlib.h>     /* malloc, realloc, free */
+#include <stdint.h>     /* uint64_t, UINT64_C */
+#include <stdlib.h>     /* calloc, free */
+#include <string.h>     /* memset */
 
 /* Local includes */
 #include <flag.h>
 #include <qltys.h>
 
 
-/* Allocates memory for the qualities array */
-qltys_t *qltys_init(void)
-{
-    qltys_t *qltys;
+/* Word of the bitmaps where the bit of a flag is */
+#define qltys_word(f)  ((f)->id / 64)
 
-    if (!(qltys = malloc(sizeof(qltys_t)))) {
-        return NULL;
-    }
+/* Bit of a flag in its word */
+#define qltys_bit(f)  (UINT64_C(1) << ((f)->id % 64))
 
-    if (!(qltys->flags = malloc(sizeof(flag_t *)))) {
-        return NULL;
-    }
 
-    qltys->len = 0;
+/* Allocates memory for the qualities set */
+qltys_t *qltys_init(void)
+{
+    return calloc(1, sizeof(qltys_t));
+}
+
 
-    return qltys;
+/* Empties a qualities set already allocated */
+void qltys_init_at(qltys_t *qltys)
+{
+    memset(qltys, 0, sizeof(qltys_t));
 }
 
 
 /* Frees allocated memory */
-void qltys_destroy(qltys_t *qltys, bool destroy_flags)
+void qltys_destroy(qltys_t *qltys)
 {
-    if (qltys->flags && destroy_flags) {
-        for (size_t i = 0; i < qltys->len; ++i) {
-            flag_destroy(qltys->flags[i]);
-        }
-    }
-    free(qltys->flags);
     free(qltys);
 }
 
 
-/* Checks if the array contains a specific flag */
-bool qltys_has_flag(qltys_t *qltys, flag_t *flag)
+/* Checks if the set contains a specific flag */
+bool qltys_has_flag(const qltys_t *qltys, const flag_t *flag)
 {
     if (!qltys || !flag) {
         return false;
     }
 
-    for (size_t i = 0; i < qltys->len; ++i) {
-        if (qltys->flags[i] == flag) {
-            return true;
-        }
+    return qltys->has[qltys_word(flag)] & qltys_bit(flag);
+}
+
+
+/* Gets the state of a flag in the set */
+bool qltys_state(const qltys_t *qltys, const flag_t *flag)
+{
+    if (!qltys || !flag) {
+        return false;
     }
 
-    return false;
+    return qltys->state[qltys_word(flag)] & qltys_bit(flag);
 }
 
 
-/* Searches for and toggles a flag in the array */
-bool qltys_toggle_flag(qltys_t *qltys, flag_t *flag)
+/* Toggles the state of a flag in the set */
+bool qltys_toggle_flag(qltys_t *qltys, const flag_t *flag)
 {
-    for (size_t i = 0; i < qltys->len; ++i) {
-        if (qltys->flags[i] == flag) {
-            flag_toggle(qltys->flags[i]);
-            return true;
-        }
+    if (!qltys_has_flag(qltys, flag)) {
+        return false;
     }
+    qltys->state[qltys_word(flag)] ^= qltys_bit(flag);
 
-    return false;
+    return true;
 }
 
 
-/* Adds a new flag to the qualities array */
-bool qltys_add(qltys_t *qltys, flag_t *flag)
+/* Adds a new flag to the qualities set */
+bool qltys_add(qltys_t *qltys, const flag_t *flag)
 {
     if (!flag || !qltys || qltys_has_flag(qltys, flag)) {
         return false;
     }
 
-    qltys->flags = realloc(qltys->flags,
-                           sizeof(flag_t *) * (qltys->len + 1));
-    if (!qltys->flags) {
-        return false;
+    qltys->has[qltys_word(flag)] |= qltys_bit(flag);
+    if (flag->initial) {
+        qltys->state[qltys_word(flag)] |= qltys_bit(flag);
     }
 
-    qltys->flags[qltys->len] = flag;
-    qltys->len++;
-
     return true;
 }
 
 
-/* Removes a new flag to the qualities array */
-bool qltys_rem(qltys_t *qltys, flag_t *flag)
+/* Removes a flag from the qualities set */
+bool qltys_rem(qltys_t *qltys, const flag_t *flag)
 {
-    if (!flag || !qltys || !qltys_has_flag(qltys, flag) || qltys->len == 0) {
+    if (!qltys_has_flag(qltys, flag)) {
         return false;
     }
 
-    for (size_t i = 0; i < qltys->len; ++i) {
-        if (qltys->flags[i] == flag) {
-            for (size_t j = i; j < qltys->len; ++j) {
-                qltys->flags[j] = qltys->flags[j+1];
-            }
-            qltys->flags = realloc(qltys->flags,
-                    sizeof(flag_t *) * qltys->len);
-            if (!qltys->flags) {
-                return false;
-            }
-            qltys->len--;
-        }
-    }
+    qltys->has[qltys_word(flag)] &= ~qltys_bit(flag);
+    qltys->state[qltys_word(flag)] &= ~qltys_bit(flag);
 
     return true;
 }
 
+
+/* Checks if the set has every flag of a pattern, with the same state */
+bool qltys_match(const qltys_t *qltys, const qltys_t *pattern)
+{
+    uint64_t diff = 0;
+
+    for (size_t i = 0; i < QLTYS_WORDS; ++i) {
+        diff |= (pattern->has[i] & ~qltys->has[i]) |
+                (pattern->state[i] ^ (qltys->state[i] & pattern->has[i]));
+    }
+
+    return diff == 0;
+}
+
+
+/* Counts the flags in the set */
+size_t qltys_count(const qltys_t *qltys)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < QLTYS_WORDS; ++i) {
+        count += __builtin_popcountll(qltys->has[i]);
+    }
+
+    return count;
+}
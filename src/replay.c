@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file replay.c
+ *
+ * @brief Plays again every line of a transcript implementation
+ *
+ * The answers go to a printer that only counts them every time it's
+ * flushed, so they are never kept whole, however long the transcript.
+ * The digest is made of the words of every command found, as the
+ * parser tells of them, and not of the answers: what is printed
+ * depends on the build, and when it's flushed, on the buffer.
+ */
+
+/* System includes */
+#include <fcntl.h>      /* open */
+#include <stdint.h>     /* uint64_t */
+#include <string.h>     /* memchr, strlen */
+#include <sys/mman.h>   /* mmap, munmap, madvise */
+#include <sys/stat.h>   /* fstat */
+#include <time.h>       /* clock_gettime */
+#include <unistd.h>     /* close */
+
+/* Local includes */
+#include <atom.h>
+#include <cmd.h>
+#include <parser.h>
+#include <printer.h>
+#include <replay.h>
+#include <turn.h>
+
+
+/* Current time, in nanoseconds */
+static inline uint64_t replay_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+
+/* Adds some bytes to a digest */
+static inline uint64_t replay_fnv(uint64_t h, const char *s, size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char) s[i];
+        h *= 0x100000001b3ULL;
+    }
+
+    return h;
+}
+
+
+/* Counts the output of the printer */
+static int replay_count(const char *s, size_t len, void *data)
+{
+    replay_stats_t *stats = data;
+
+    (void) s;
+    stats->bytes += len;
+
+    return 0;
+}
+
+
+/* Adds the words of a command, and whether it was understood, to the
+ * digest; every word ends with a null character, so they can't run
+ * into each other */
+static void replay_cmd(const cmdv_t *cmd, int ret_val, void *data)
+{
+    replay_stats_t *stats = data;
+    const cword_t *words[] = { &cmd->action, &cmd->mode, &cmd->quantity,
+                               &cmd->quality, &cmd->dobj, &cmd->iobj };
+    uint64_t h = stats->digest;
+    char understood = ret_val == 0 ? 'y' : 'n';
+
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); ++i) {
+        const char *word = atom_str(words[i]->atom);
+        h = word ? replay_fnv(h, word, strlen(word) + 1)
+                 : replay_fnv(h, "", 1);
+    }
+    h = replay_fnv(h, cmd->unknown.s, cmd->unknown.len);
+    stats->digest = replay_fnv(h, &understood, 1);
+}
+
+
+/* Handles every line of a file, as the turns of a player */
+int replay_file(const char *path, replay_stats_t *stats)
+{
+    struct stat st;
+    const char *map;
+    const char *p;
+    const char *end;
+    printer_t *out;
+    turn_t turn;
+    uint64_t start;
+    int fd;
+
+    if (!path || !stats || parser_init() != 0) {
+        return 1;
+    }
+    stats->lines = 0;
+    stats->bytes = 0;
+    stats->digest = REPLAY_DIGEST_INIT;
+    stats->ns = 0;
+
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        return 2;
+    }
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return 2;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return 2;
+    }
+    madvise((void *) map, st.st_size, MADV_SEQUENTIAL);
+    if (!(out = printer_init_cb(replay_count, stats))) {
+        munmap((void *) map, st.st_size);
+        return 1;
+    }
+    turn_init_at(&turn, out);
+    parser_set_observer(replay_cmd, stats);
+
+    start = replay_now();
+    for (p = map, end = map + st.st_size; p < end && !turn.quit; ) {
+        const char *eol = memchr(p, '\n', end - p);
+        const char *next = eol ? eol + 1 : end;
+
+        if (!eol) {
+            eol = end;
+        }
+        if (eol > p && eol[-1] == '\r') {
+            --eol;
+        }
+        turn_line(&turn, p, eol - p);
+        p = next;
+    }
+    parser_set_observer(NULL, NULL);
+    printer_destroy(out);   /* the last answers get counted */
+    stats->ns = replay_now() - start;
+    stats->lines = turn.count;
+    munmap((void *) map, st.st_size);
+
+    return 0;
+}
@@ -0,0 +1,674 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file server.c
+ *
+ * @brief Serves many players at once implementation
+ *
+ * Every shard is a thread with its own @e epoll instance, and a session
+ * belongs to the shard that accepted it.  The sockets are non-blocking
+ * and their events one-shot: a session reported ready is put in the
+ * queue of its shard and nobody hears of it again until it's armed
+ * once handled, so only one thread at a time touches it.  A session is
+ * read once per turn, so a player typing a lot can't keep the others
+ * waiting.
+ *
+ * A shard that finds more work than it can do at once wakes an idle
+ * shard, which steals sessions from the end of the queues of the
+ * others.  The answers are kept in the printer of the session until
+ * the socket takes them, and only then the session waits for it to be
+ * writable.
+ */
+
+#define _GNU_SOURCE     /* accept4 */
+
+/* System includes */
+#include <errno.h>      /* errno, EAGAIN, EINTR, EEXIST, ENOENT */
+#include <pthread.h>    /* pthread_create, pthread_join, pthread_mutex_* */
+#include <stdatomic.h>  /* atomic_uint, atomic_bool, atomic_load */
+#include <stdbool.h>    /* bool, true, false */
+#include <stdint.h>     /* uint32_t, uint64_t */
+#include <stdlib.h>     /* malloc, calloc, realloc, free */
+#include <string.h>     /* memchr, memmove, strlen, strcpy */
+#include <sys/epoll.h>  /* epoll_create1, epoll_ctl, epoll_wait */
+#include <sys/eventfd.h>    /* eventfd */
+#include <sys/socket.h> /* socket, bind, listen, accept4, send */
+#include <sys/stat.h>   /* lstat, S_ISSOCK */
+#include <sys/types.h>  /* ssize_t */
+#include <sys/un.h>     /* sockaddr_un */
+#include <unistd.h>     /* read, write, close, unlink, sysconf */
+
+/* Local includes */
+#include <parser.h>
+#include <printer.h>
+#include <server.h>
+#include <turn.h>
+
+#define SERVER_ACCEPT_MAX  (16)     /**< Connections taken per wake */
+
+
+struct shard;
+
+
+/**
+ * @typedef session_t
+ *
+ * @brief Connection of a player
+ */
+typedef struct {
+    int fd;                 /**< Socket */
+    struct shard *home;     /**< Shard that owns the session */
+    size_t slot;            /**< Position in the list of its shard */
+    uint32_t events;        /**< Events reported, while queued */
+    turn_t turn;            /**< State of the commands */
+    size_t sent;            /**< Bytes of the answers already sent */
+    bool eof;               /**< Whether the player stopped writing */
+    bool skip;              /**< Whether a line too long is ignored */
+    size_t len;             /**< Bytes in @e line */
+    char line[SERVER_LINE_MAX];     /**< Input not handled yet */
+} session_t;
+
+
+/**
+ * @typedef shard_t
+ *
+ * @brief Thread serving its own sessions
+ */
+typedef struct shard {
+    pthread_t thread;       /**< Thread, if not the caller */
+    int epfd;               /**< Instance of @e epoll */
+    struct server *server;  /**< Server the shard is part of */
+    pthread_mutex_t lock;   /**< Protects the fields below */
+    session_t **queue;      /**< Sessions ready, as a ring */
+    size_t head;            /**< First session of the queue */
+    size_t queued;          /**< Sessions in the queue */
+    size_t queue_cap;       /**< Allocated length of the queue */
+    session_t **list;       /**< Sessions owned */
+    size_t len;             /**< Number of sessions owned */
+    size_t cap;             /**< Allocated length of the list */
+} shard_t;
+
+
+/**
+ * @typedef server_t
+ *
+ * @brief Every shard, and what they share
+ */
+typedef struct server {
+    shard_t *shards;        /**< Shards */
+    unsigned nshards;       /**< Number of shards */
+    int listener;           /**< Socket listened to */
+    int wake;               /**< Event to wake an idle shard */
+    atomic_uint idle;       /**< Shards waiting for events */
+} server_t;
+
+
+/* The events of the listener and of the event files have no session,
+ * but the address of one of these */
+static char tag_listener;
+static char tag_wake;
+static char tag_stop;
+
+/* Being lock-free, the flag can be set from a signal handler too */
+static atomic_bool stopping = false;    /**< Set by @e server_stop */
+static int stop_fd = -1;                /**< Wakes every shard */
+
+
+/* Number of shards to use */
+static unsigned server_nshards(unsigned nthreads)
+{
+    long ncores;
+
+    if (nthreads) {
+        return nthreads < SERVER_THREADS_MAX ? nthreads : SERVER_THREADS_MAX;
+    }
+    ncores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return ncores <= 0 ? 1 : ncores < SERVER_THREADS_MAX ?
+           (unsigned) ncores : SERVER_THREADS_MAX;
+}
+
+
+/* Opens the socket to listen to */
+static int server_listen(const char *path)
+{
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    struct stat st;
+    int fd;
+
+    if (!path || strlen(path) >= sizeof(addr.sun_path)) {
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    /* Only a socket left by a previous run is replaced */
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            errno = EEXIST;
+            return -1;
+        }
+        if (unlink(path) != 0) {
+            return -1;
+        }
+    } else if (errno != ENOENT) {
+        return -1;
+    }
+
+    if ((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                     0)) < 0) {
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+            listen(fd, SERVER_BACKLOG) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+
+/* Adds a file to the events of a shard */
+static bool shard_watch(shard_t *shard, int fd, uint32_t events, void *tag)
+{
+    struct epoll_event ev = { .events = events, .data.ptr = tag };
+
+    return epoll_ctl(shard->epfd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+
+/* Puts a ready session at the end of the queue of a shard */
+static bool shard_push(shard_t *shard, session_t *session)
+{
+    bool pushed = true;
+
+    pthread_mutex_lock(&shard->lock);
+    if (shard->queued == shard->queue_cap) {
+        size_t cap = shard->queue_cap ? shard->queue_cap * 2 : 64;
+        session_t **queue = malloc(sizeof(session_t *) * cap);
+        if (queue) {
+            for (size_t i = 0; i < shard->queued; ++i) {
+                queue[i] = shard->queue[(shard->head + i) %
+                                        shard->queue_cap];
+            }
+            free(shard->queue);
+            shard->queue = queue;
+            shard->queue_cap = cap;
+            shard->head = 0;
+        } else {
+            pushed = false;
+        }
+    }
+    if (pushed) {
+        shard->queue[(shard->head + shard->queued) % shard->queue_cap] =
+            session;
+        shard->queued++;
+    }
+    pthread_mutex_unlock(&shard->lock);
+
+    return pushed;
+}
+
+
+/* Number of sessions in the queue of a shard */
+static size_t shard_queued(shard_t *shard)
+{
+    size_t queued;
+
+    pthread_mutex_lock(&shard->lock);
+    queued = shard->queued;
+    pthread_mutex_unlock(&shard->lock);
+
+    return queued;
+}
+
+
+/* Takes a session from the start of the queue of a shard, or from the
+ * end when stolen, so the thief takes what the owner would do last */
+static session_t *shard_pop(shard_t *shard, bool steal)
+{
+    session_t *session = NULL;
+
+    pthread_mutex_lock(&shard->lock);
+    if (shard->queued > 0) {
+        shard->queued--;
+        if (steal) {
+            session = shard->queue[(shard->head + shard->queued) %
+                                   shard->queue_cap];
+        } else {
+            session = shard->queue[shard->head];
+            shard->head = (shard->head + 1) % shard->queue_cap;
+        }
+    }
+    pthread_mutex_unlock(&shard->lock);
+
+    return session;
+}
+
+
+/* Takes a ready session of another shard */
+static session_t *shard_steal(shard_t *shard)
+{
+    server_t *server = shard->server;
+    size_t self = (size_t) (shard - server->shards);
+
+    for (unsigned i = 1; i < server->nshards; ++i) {
+        session_t *session =
+            shard_pop(&server->shards[(self + i) % server->nshards], true);
+        if (session) {
+            return session;
+        }
+    }
+
+    return NULL;
+}
+
+
+/* Waits again for the events a session needs now */
+static bool session_arm(session_t *session, int op)
+{
+    struct epoll_event ev = { .data.ptr = session };
+    size_t len;
+
+    printer_data(session->turn.out, &len);
+    ev.events = EPOLLONESHOT;
+    if (!session->eof && !session->turn.quit) {
+        ev.events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (session->sent < len) {
+        ev.events |= EPOLLOUT;
+    }
+
+    return epoll_ctl(session->home->epfd, op, session->fd, &ev) == 0;
+}
+
+
+/* Sends as much of the answers as the socket takes */
+static bool session_send(session_t *session)
+{
+    size_t len;
+    const char *data = printer_data(session->turn.out, &len);
+
+    while (session->sent < len) {
+        ssize_t n = send(session->fd, data + session->sent,
+                         len - session->sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return false;
+        }
+        session->sent += (size_t) n;
+    }
+
+    if (session->sent == len) {
+        printer_clear(session->turn.out);
+        session->sent = 0;
+        if (session->eof || session->turn.quit) {
+            return false;   /* nothing else to do */
+        }
+    } else if (len - session->sent > SERVER_OUT_MAX) {
+        return false;       /* the player doesn't read */
+    }
+
+    return true;
+}
+
+
+/* Handles every complete line of the input */
+static void session_lines(session_t *session)
+{
+    char *start = session->line;
+    char *end = session->line + session->len;
+    char *nl;
+
+    while (!session->turn.quit &&
+            (nl = memchr(start, '\n', (size_t) (end - start)))) {
+        if (!session->skip) {
+            size_t len = (size_t) (nl - start);
+            if (len > 0 && start[len - 1] == '\r') {
+                len--;
+            }
+            turn_line(&session->turn, start, len);
+            if (!session->turn.quit) {
+                turn_prompt(&session->turn);
+            }
+        }
+        session->skip = false;
+        start = nl + 1;
+    }
+
+    session->len = (size_t) (end - start);
+    memmove(session->line, start, session->len);
+    if (session->len == SERVER_LINE_MAX) {
+        session->skip = true;
+        session->len = 0;
+    }
+}
+
+
+/* Reads what a player wrote, once */
+static bool session_read(session_t *session)
+{
+    ssize_t n;
+
+    do {
+        n = read(session->fd, session->line + session->len,
+                 SERVER_LINE_MAX - session->len);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    if (n == 0) {
+        /* The last line may not end with a newline */
+        session->eof = true;
+        if (session->len > 0 && !session->skip) {
+            session->line[session->len++] = '\n';
+        }
+    } else {
+        session->len += (size_t) n;
+    }
+    session_lines(session);
+
+    return true;
+}
+
+
+/* Closes a session, whatever shard is handling it */
+static void session_close(session_t *session)
+{
+    shard_t *home = session->home;
+
+    pthread_mutex_lock(&home->lock);
+    home->list[session->slot] = home->list[--home->len];
+    home->list[session->slot]->slot = session->slot;
+    pthread_mutex_unlock(&home->lock);
+
+    close(session->fd);
+    printer_destroy(session->turn.out);
+    free(session);
+}
+
+
+/* Handles the events of a session, and waits for the next ones */
+static void session_run(session_t *session)
+{
+    bool alive = true;
+
+    if (session->events & EPOLLERR) {
+        alive = false;
+    } else if (session->events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) {
+        alive = session_read(session);
+    }
+    if (!alive || !session_send(session) ||
+            !session_arm(session, EPOLL_CTL_MOD)) {
+        session_close(session);
+    }
+}
+
+
+/* Opens a session for a new connection in a shard */
+static bool session_open(shard_t *shard, int fd)
+{
+    session_t *session;
+    printer_t *out;
+
+    if (!(session = malloc(sizeof(session_t)))) {
+        return false;
+    }
+    if (!(out = printer_init_mem())) {
+        free(session);
+        return false;
+    }
+
+    session->fd = fd;
+    session->home = shard;
+    session->events = 0;
+    turn_init_at(&session->turn, out);
+    session->sent = 0;
+    session->eof = false;
+    session->skip = false;
+    session->len = 0;
+
+    pthread_mutex_lock(&shard->lock);
+    if (shard->len == shard->cap) {
+        size_t cap = shard->cap ? shard->cap * 2 : 64;
+        session_t **list = realloc(shard->list, sizeof(session_t *) * cap);
+        if (list) {
+            shard->list = list;
+            shard->cap = cap;
+        }
+    }
+    if (shard->len < shard->cap) {
+        session->slot = shard->len;
+        shard->list[shard->len++] = session;
+    } else {
+        session->slot = SIZE_MAX;
+    }
+    pthread_mutex_unlock(&shard->lock);
+
+    if (session->slot == SIZE_MAX) {
+        printer_destroy(out);
+        free(session);
+        return false;
+    }
+
+    /* Nobody else can see the session until it's armed */
+    turn_prompt(&session->turn);
+    if (!session_send(session) || !session_arm(session, EPOLL_CTL_ADD)) {
+        session_close(session);
+    }
+
+    return true;
+}
+
+
+/* Takes some of the connections waiting */
+static void shard_accept(shard_t *shard)
+{
+    int fd;
+
+    for (int i = 0; i < SERVER_ACCEPT_MAX &&
+            (fd = accept4(shard->server->listener, NULL, NULL,
+                          SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0; ++i) {
+        if (!session_open(shard, fd)) {
+            close(fd);
+        }
+    }
+}
+
+
+/* Waits for events and handles the sessions of a shard, or of others
+ * when it has nothing to do */
+static void *shard_loop(void *arg)
+{
+    shard_t *shard = arg;
+    server_t *server = shard->server;
+    struct epoll_event events[SERVER_EVENTS];
+
+    while (!atomic_load(&stopping)) {
+        bool busy = shard_queued(shard) > 0;
+        int n;
+
+        if (!busy) {
+            atomic_fetch_add(&server->idle, 1);
+        }
+        n = epoll_wait(shard->epfd, events, SERVER_EVENTS, busy ? 0 : -1);
+        if (!busy) {
+            atomic_fetch_sub(&server->idle, 1);
+        }
+        if (n < 0 && errno != EINTR) {
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            void *tag = events[i].data.ptr;
+            session_t *session = tag;
+            uint64_t count;
+
+            if (tag == &tag_stop) {
+                atomic_store(&stopping, true);
+            } else if (tag == &tag_listener) {
+                shard_accept(shard);
+            } else if (tag == &tag_wake) {
+                if (read(server->wake, &count, sizeof(count)) < 0) {
+                    continue;   /* another shard took it */
+                }
+            } else {
+                session->events = events[i].events;
+                if (!shard_push(shard, session)) {
+                    session_close(session);
+                }
+            }
+        }
+        if (shard_queued(shard) > 1 && atomic_load(&server->idle) > 0) {
+            uint64_t one = 1;
+            if (write(server->wake, &one, sizeof(one)) < 0) {
+                /* the counter is full, so every shard is awake */
+            }
+        }
+
+        /* Some sessions, and then back to see what's new */
+        for (int i = 0; i < SERVER_EVENTS && !atomic_load(&stopping); ++i) {
+            session_t *session = shard_pop(shard, false);
+            if (!session && !(session = shard_steal(shard))) {
+                break;
+            }
+            session_run(session);
+        }
+    }
+    parser_free_turn();
+
+    return NULL;
+}
+
+
+/* Frees a shard and closes its sessions */
+static void shard_destroy(shard_t *shard)
+{
+    while (shard->len > 0) {
+        session_close(shard->list[shard->len - 1]);
+    }
+    free(shard->list);
+    free(shard->queue);
+    pthread_mutex_destroy(&shard->lock);
+    close(shard->epfd);
+}
+
+
+/* Sets up a shard, listening to the socket and the event files */
+static bool shard_init(shard_t *shard, server_t *server)
+{
+    shard->server = server;
+    shard->queue = NULL;
+    shard->head = 0;
+    shard->queued = 0;
+    shard->queue_cap = 0;
+    shard->list = NULL;
+    shard->len = 0;
+    shard->cap = 0;
+    if ((shard->epfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        return false;
+    }
+    pthread_mutex_init(&shard->lock, NULL);
+
+    /* One shard is woken per connection or request to steal, but
+     * every shard is woken to stop, as that event is never read */
+    if (!shard_watch(shard, server->listener, EPOLLIN | EPOLLEXCLUSIVE,
+                     &tag_listener) ||
+            !shard_watch(shard, server->wake, EPOLLIN | EPOLLEXCLUSIVE,
+                         &tag_wake) ||
+            !shard_watch(shard, stop_fd, EPOLLIN, &tag_stop)) {
+        shard_destroy(shard);
+        return false;
+    }
+
+    return true;
+}
+
+
+/* Serves sessions on a Unix domain socket until stopped */
+int server_run(const char *path, unsigned nthreads)
+{
+    server_t server;
+    unsigned ready = 0;
+    unsigned created = 0;
+    int ret_val = 1;
+
+    server.nshards = server_nshards(nthreads);
+    atomic_init(&server.idle, 0);
+    server.wake = -1;
+    if ((server.listener = server_listen(path)) < 0) {
+        return 1;
+    }
+    if (!(server.shards = malloc(sizeof(shard_t) * server.nshards)) ||
+            (server.wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0 ||
+            (stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+        goto out;
+    }
+    while (ready < server.nshards &&
+            shard_init(&server.shards[ready], &server)) {
+        ready++;
+    }
+    if (ready < server.nshards) {
+        goto out;
+    }
+
+    /* The caller is the first shard */
+    atomic_store(&stopping, false);
+    while (created + 1 < server.nshards &&
+            pthread_create(&server.shards[created + 1].thread, NULL,
+                           shard_loop, &server.shards[created + 1]) == 0) {
+        created++;
+    }
+    shard_loop(&server.shards[0]);
+    server_stop();
+    while (created > 0) {
+        pthread_join(server.shards[created--].thread, NULL);
+    }
+    ret_val = 0;
+
+out:
+    while (ready > 0) {
+        shard_destroy(&server.shards[--ready]);
+    }
+    free(server.shards);
+    if (stop_fd >= 0) {
+        close(stop_fd);
+        stop_fd = -1;
+    }
+    if (server.wake >= 0) {
+        close(server.wake);
+    }
+    close(server.listener);
+    unlink(path);
+
+    return ret_val;
+}
+
+
+/* Asks the server to stop */
+void server_stop(void)
+{
+    uint64_t one = 1;
+
+    atomic_store(&stopping, true);
+    if (stop_fd >= 0 && write(stop_fd, &one, sizeof(one)) < 0) {
+        return;     /* already asked */
+    }
+}
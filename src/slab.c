@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file slab.c
+ *
+ * @brief Allocator of objects of a fixed size implementation
+ *
+ * Every block starts with a pointer to the previous block, and the
+ * objects follow it.  A free object holds a pointer to the next free
+ * object, so the objects are never smaller than a pointer.
+ */
+
+/* System includes */
+#include <pthread.h>    /* pthread_mutex_* */
+#include <stdalign.h>   /* alignof */
+#include <stddef.h>     /* max_align_t */
+#include <stdlib.h>     /* malloc, free */
+
+/* Local includes */
+#include <slab.h>
+
+
+/* Space between objects, aligned for any type */
+static inline size_t slab_stride(const slab_t *slab)
+{
+    size_t align = alignof(max_align_t);
+    size_t size = slab->size < sizeof(void *) ? sizeof(void *) : slab->size;
+
+    return (size + align - 1) / align * align;
+}
+
+
+/* Space before the first object of a block */
+#define SLAB_HEADER  \
+    ((sizeof(void *) + alignof(max_align_t) - 1) / alignof(max_align_t) * \
+     alignof(max_align_t))
+
+
+/* Takes a new object from a slab */
+void *slab_alloc(slab_t *slab)
+{
+    void *obj = NULL;
+
+    pthread_mutex_lock(&slab->lock);
+    if (slab->free) {
+        obj = slab->free;
+        slab->free = *(void **) obj;
+    } else {
+        if (slab->used == slab->per_block) {
+            void *block = malloc(SLAB_HEADER +
+                                 slab_stride(slab) * slab->per_block);
+            if (!block) {
+                pthread_mutex_unlock(&slab->lock);
+                return NULL;
+            }
+            *(void **) block = slab->blocks;
+            slab->blocks = block;
+            slab->used = 0;
+        }
+        obj = (char *) slab->blocks + SLAB_HEADER +
+              slab_stride(slab) * slab->used;
+        slab->used++;
+    }
+    pthread_mutex_unlock(&slab->lock);
+
+    return obj;
+}
+
+
+/* Gives back an object to a slab */
+void slab_free(slab_t *slab, void *obj)
+{
+    if (!obj) {
+        return;
+    }
+
+    pthread_mutex_lock(&slab->lock);
+    *(void **) obj = slab->free;
+    slab->free = obj;
+    pthread_mutex_unlock(&slab->lock);
+}
+
+
+/* Frees every block of a slab */
+void slab_destroy(slab_t *slab)
+{
+    pthread_mutex_lock(&slab->lock);
+    while (slab->blocks) {
+        void *prev = *(void **) slab->blocks;
+        free(slab->blocks);
+        slab->blocks = prev;
+    }
+    slab->free = NULL;
+    slab->used = slab->per_block;
+    pthread_mutex_unlock(&slab->lock);
+}
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file store.c
+ *
+ * @brief Central store of items implementation
+ *
+ * The identifier of an item is its index in the store: the page is the
+ * identifier divided by the size of a page, and the rest is the index
+ * in the arrays of the page.  The identifiers start at 1, so the first
+ * entry is never used.
+ *
+ * The identifiers of the items removed are kept in a list linked
+ * through their own entries, and given again before taking new ones,
+ * so the store only grows up to the most items alive at once.
+ *
+ * Items are added and removed under the lock, but looked up without
+ * it: the pointers to the pages, to the items and to their owners are
+ * atomic, and an item is published, with release, only once the rest
+ * of its entry is set, so whoever finds the item with acquire sees its
+ * entry whole.  Removing an item only unpublishes it; the rest of the
+ * entry is set again when the identifier is given to a new item.
+ */
+
+/* System includes */
+#include <pthread.h>    /* pthread_mutex_* */
+#include <stdatomic.h>  /* atomic_* */
+#include <stdbool.h>    /* bool, true, false */
+#include <stdint.h>     /* uint32_t */
+#include <stdlib.h>     /* calloc, free */
+
+/* Local includes */
+#include <inventory.h>
+#include <item.h>
+#include <qltys.h>
+#include <store.h>
+
+
+/* Page of parallel arrays */
+typedef struct {
+    _Atomic(item_t *) items[STORE_PAGE];
+    weight_t weight[STORE_PAGE];
+    _Atomic(inv_t *) owner[STORE_PAGE];
+    qltys_t qltys[STORE_PAGE];
+    uint32_t next_free[STORE_PAGE];
+} store_page_t;
+
+
+static _Atomic(store_page_t *) store_pages[STORE_MAX_PAGES];  /**< Pages */
+static _Atomic size_t store_len = 0;        /**< Pages in use */
+static uint32_t store_last_id = 0;          /**< Last identifier given */
+static uint32_t store_free = 0;             /**< Identifier to give again */
+static pthread_mutex_t store_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* Page of an identifier, NULL if there's no such page */
+static inline store_page_t *store_page(uint32_t id)
+{
+    return id / STORE_PAGE < STORE_MAX_PAGES ?
+           atomic_load_explicit(&store_pages[id / STORE_PAGE],
+                                memory_order_acquire) : NULL;
+}
+
+
+/* Item of an entry of a page */
+static inline item_t *store_item(const store_page_t *page, size_t i)
+{
+    return atomic_load_explicit(&page->items[i], memory_order_acquire);
+}
+
+
+/* Owner of an entry of a page */
+static inline inv_t *store_item_owner(const store_page_t *page, size_t i)
+{
+    return atomic_load_explicit(&page->owner[i], memory_order_acquire);
+}
+
+
+/* Page of an item, NULL if there's no such item */
+static inline store_page_t *store_page_of(uint32_t id)
+{
+    store_page_t *page = store_page(id);
+
+    return page && store_item(page, id % STORE_PAGE) ? page : NULL;
+}
+
+
+/* Takes an identifier, and the page where it is */
+static store_page_t *store_take_id(uint32_t *id)
+{
+    store_page_t *page;
+
+    if (store_free) {
+        *id = store_free;
+        page = store_page(*id);
+        store_free = page->next_free[*id % STORE_PAGE];
+        return page;
+    }
+
+    *id = store_last_id + 1;
+    if (*id / STORE_PAGE >= STORE_MAX_PAGES) {
+        return NULL;
+    }
+    if (!(page = store_page(*id))) {
+        if (!(page = calloc(1, sizeof(store_page_t)))) {
+            return NULL;
+        }
+        atomic_store_explicit(&store_pages[*id / STORE_PAGE], page,
+                              memory_order_release);
+        atomic_store(&store_len, *id / STORE_PAGE + 1);
+    }
+    store_last_id = *id;
+
+    return page;
+}
+
+
+/* Adds an item to the store */
+bool store_add(item_t *item)
+{
+    store_page_t *page;
+    uint32_t id;
+    size_t i;
+
+    if (!item) {
+        return false;
+    }
+
+    pthread_mutex_lock(&store_lock);
+    if (!(page = store_take_id(&id))) {
+        pthread_mutex_unlock(&store_lock);
+        return false;
+    }
+
+    i = id % STORE_PAGE;
+    item->id = id;
+    page->weight[i] = item->weight;
+    atomic_store_explicit(&page->owner[i], NULL, memory_order_relaxed);
+    qltys_init_at(&page->qltys[i]);
+    item->qltys = &page->qltys[i];
+    atomic_store_explicit(&page->items[i], item, memory_order_release);
+    pthread_mutex_unlock(&store_lock);
+
+    return true;
+}
+
+
+/* Removes an item from the store */
+void store_rem(item_t *item)
+{
+    store_page_t *page;
+    size_t i;
+
+    if (!item || !(page = store_page_of(item->id))) {
+        return;
+    }
+
+    i = item->id % STORE_PAGE;
+    pthread_mutex_lock(&store_lock);
+    atomic_store_explicit(&page->items[i], NULL, memory_order_release);
+    atomic_store_explicit(&page->owner[i], NULL, memory_order_release);
+    page->next_free[i] = store_free;
+    store_free = item->id;
+    pthread_mutex_unlock(&store_lock);
+}
+
+
+/* Gets an item by its identifier */
+item_t *store_get(uint32_t id)
+{
+    store_page_t *page = store_page(id);
+
+    return page ? store_item(page, id % STORE_PAGE) : NULL;
+}
+
+
+/* Gets the inventory where an item is */
+inv_t *store_owner(uint32_t id)
+{
+    store_page_t *page = store_page_of(id);
+
+    return page ? store_item_owner(page, id % STORE_PAGE) : NULL;
+}
+
+
+/* Sets the inventory where an item is */
+void store_set_owner(uint32_t id, inv_t *inv)
+{
+    store_page_t *page = store_page_of(id);
+
+    if (page) {
+        atomic_store_explicit(&page->owner[id % STORE_PAGE], inv,
+                              memory_order_release);
+    }
+}
+
+
+/* Gets the weight of an item */
+weight_t store_weight(uint32_t id)
+{
+    store_page_t *page = store_page_of(id);
+
+    return page ? page->weight[id % STORE_PAGE] : 0;
+}
+
+
+/* Sets the weight of an item */
+bool store_set_weight(uint32_t id, weight_t weight)
+{
+    store_page_t *page = store_page_of(id);
+    size_t i = id % STORE_PAGE;
+    inv_t *owner;
+
+    if (!page) {
+        return false;
+    }
+
+    if ((owner = store_item_owner(page, i))) {
+        owner->weight += weight - page->weight[i];
+    }
+    page->weight[i] = weight;
+    store_item(page, i)->weight = weight;
+
+    return true;
+}
+
+
+/* Sums the weight of every item in an inventory */
+weight_t store_eval_weight(const inv_t *inv)
+{
+    weight_t weight = 0;
+
+    if (!inv) {
+        return 0;
+    }
+    for (size_t p = 0, len = atomic_load(&store_len); p < len; ++p) {
+        const store_page_t *page = store_page(p * STORE_PAGE);
+        if (!page) {
+            continue;
+        }
+        for (size_t i = 0; i < STORE_PAGE; ++i) {
+            weight += store_item_owner(page, i) == inv ? page->weight[i] : 0;
+        }
+    }
+
+    return weight;
+}
+
+
+/* Finds every item with the flags of a pattern */
+size_t store_match(const qltys_t *pattern, const inv_t *inv,
+                   item_t **items, size_t max)
+{
+    size_t found = 0;
+
+    for (size_t p = 0, len = atomic_load(&store_len); p < len; ++p) {
+        const store_page_t *page = store_page(p * STORE_PAGE);
+        if (!page) {
+            continue;
+        }
+        for (size_t i = 0; i < STORE_PAGE; ++i) {
+            item_t *item = store_item(page, i);
+            if (!item || (inv && store_item_owner(page, i) != inv) ||
+                    !qltys_match(&page->qltys[i], pattern)) {
+                continue;
+            }
+            if (items && found < max) {
+                items[found] = item;
+            }
+            found++;
+        }
+    }
+
+    return found;
+}
+
+
+/* Frees the memory of the store */
+void store_destroy(void)
+{
+    pthread_mutex_lock(&store_lock);
+    for (size_t p = 0; p < store_len; ++p) {
+        free(atomic_exchange(&store_pages[p], NULL));
+    }
+    store_len = 0;
+    store_last_id = 0;
+    store_free = 0;
+    pthread_mutex_unlock(&store_lock);
+}
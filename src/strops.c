@@ -15,16 +15,30 @@
  * @file strops.c
  *
  * @brief String operations implementation
+ *
+ * On x86 the normalization and the search of characters of a set work
+ * on 16 bytes at a time (SSE2, SSSE3), or on 32 bytes at a time (AVX2)
+ * when the processor supports it, which is checked every time since
+ * it's just reading a global variable.  Any other architecture, and
+ * any non-ASCII byte when normalizing, uses the scalar code.
  */
 
 /* System includes */
 #include <ctype.h>   /* isspace, tolower */
 #include <stdbool.h> /* bool, true, false */
-#include <string.h>  /* memmove, strcmp, strlen */
+#include <stdint.h>  /* uint32_t */
+#include <string.h>  /* memcpy, memmove, strcmp, strlen */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define STR_SIMD
+    #include <immintrin.h>
+#endif
 
 /* Local includes */
 #include <strops.h>
 
+#define STR_SCAN_SHORT  (16)    /**< Bytes to check before using vectors */
+
 
 /* Check if a string is in an array of strings */
 bool str_in_array(const char *s, const char **arr, size_t arr_len)
@@ -45,7 +59,7 @@ void str_trim(char *s)
     char *p = s;
     int l = strlen(p);
 
-    while (isspace(p[l - 1])) {
+    while (l > 0 && isspace(p[l - 1])) {
         p[--l] = 0;
     }
     while (*p && isspace(*p)) {
@@ -65,22 +79,338 @@ void str_transform_case(char *s, int (*f)(int))
 }
 
 
-/* Normalize string */
-void str_normalize(char **s, lettercase_t lettercase)
+/* Bounds of the non blank characters found so far */
+typedef struct {
+    size_t first;   /* First non blank character, or the length if none */
+    size_t end;     /* Past the last non blank character */
+} str_bounds_t;
+
+
+/* Updates the bounds with a mask of non blank characters of a block */
+static inline void str_bounds_mask(str_bounds_t *b, size_t pos,
+                                   uint32_t mask)
+{
+    if (mask) {
+        if (pos + __builtin_ctz(mask) < b->first) {
+            b->first = pos + __builtin_ctz(mask);
+        }
+        b->end = pos + 32 - __builtin_clz(mask);
+    }
+}
+
+
+/* Normalizes byte by byte, the same as 'str_transform_case' and
+ * 'str_trim' would do */
+static void str_normalize_scalar(char *s, size_t pos, size_t len,
+                                 bool upper, str_bounds_t *b)
+{
+    for (size_t i = pos; i < len; ++i) {
+        unsigned char c = s[i];
+
+        if (c < 0x80) {
+            if (upper ? (c >= 'a' && c <= 'z') : (c >= 'A' && c <= 'Z')) {
+                c ^= 0x20;
+            }
+        } else {
+            c = upper ? toupper(c) : tolower(c);
+        }
+        s[i] = c;
+
+        if (!isspace(c)) {
+            if (i < b->first) {
+                b->first = i;
+            }
+            b->end = i + 1;
+        }
+    }
+}
+
+
+#ifdef STR_SIMD
+/* Normalizes blocks of 16 bytes until a non-ASCII byte is found */
+__attribute__((target("sse2")))
+static size_t str_normalize_sse2(char *s, size_t pos, size_t len,
+                                 bool upper, str_bounds_t *b)
 {
-    switch (lettercase) {
-        case UPPERCASE:
-            /* str_toupper(*s); */
-            str_transform_case(*s, toupper);
+    const __m128i lo = _mm_set1_epi8(upper ? 'a' - 1 : 'A' - 1);
+    const __m128i hi = _mm_set1_epi8(upper ? 'z' + 1 : 'Z' + 1);
+    const __m128i bit = _mm_set1_epi8(0x20);
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t' - 1);
+    const __m128i cr = _mm_set1_epi8('\r' + 1);
+    size_t i = pos;
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (s + i));
+        __m128i letter;
+        __m128i blank;
+
+        if (_mm_movemask_epi8(v)) {
             break;
+        }
+        letter = _mm_and_si128(_mm_cmpgt_epi8(v, lo), _mm_cmplt_epi8(v, hi));
+        v = _mm_xor_si128(v, _mm_and_si128(letter, bit));
+        _mm_storeu_si128((__m128i *) (s + i), v);
+
+        blank = _mm_or_si128(_mm_cmpeq_epi8(v, space),
+                             _mm_and_si128(_mm_cmpgt_epi8(v, tab),
+                                           _mm_cmplt_epi8(v, cr)));
+        str_bounds_mask(b, i, ~_mm_movemask_epi8(blank) & 0xffff);
+    }
 
-        case LOWERCASE:
-        default:
-            /* str_lower(*s); */
-            str_transform_case(*s, tolower);
+    return i;
+}
+
+
+/* Normalizes blocks of 32 bytes until a non-ASCII byte is found */
+__attribute__((target("avx2")))
+static size_t str_normalize_avx2(char *s, size_t pos, size_t len,
+                                 bool upper, str_bounds_t *b)
+{
+    const __m256i lo = _mm256_set1_epi8(upper ? 'a' - 1 : 'A' - 1);
+    const __m256i hi = _mm256_set1_epi8(upper ? 'z' + 1 : 'Z' + 1);
+    const __m256i bit = _mm256_set1_epi8(0x20);
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t' - 1);
+    const __m256i cr = _mm256_set1_epi8('\r' + 1);
+    size_t i = pos;
+
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (s + i));
+        __m256i letter;
+        __m256i blank;
+
+        if (_mm256_movemask_epi8(v)) {
             break;
+        }
+        letter = _mm256_and_si256(_mm256_cmpgt_epi8(v, lo),
+                                  _mm256_cmpgt_epi8(hi, v));
+        v = _mm256_xor_si256(v, _mm256_and_si256(letter, bit));
+        _mm256_storeu_si256((__m256i *) (s + i), v);
+
+        blank = _mm256_or_si256(_mm256_cmpeq_epi8(v, space),
+                                _mm256_and_si256(_mm256_cmpgt_epi8(v, tab),
+                                                 _mm256_cmpgt_epi8(cr, v)));
+        str_bounds_mask(b, i, ~(uint32_t) _mm256_movemask_epi8(blank));
+    }
+
+    return i;
+}
+#endif
+
+
+/* Normalize a chunk of a string in place */
+span_t str_normalize_span(char *s, size_t len, lettercase_t lettercase)
+{
+    str_bounds_t b = { .first = len, .end = 0 };
+    bool upper = (lettercase == UPPERCASE);
+    size_t pos = 0;
+
+#ifdef STR_SIMD
+    if (len >= 32 && __builtin_cpu_supports("avx2")) {
+        pos = str_normalize_avx2(s, pos, len, upper, &b);
+    }
+    if (len - pos >= 16 && __builtin_cpu_supports("sse2")) {
+        pos = str_normalize_sse2(s, pos, len, upper, &b);
+    }
+#endif
+    str_normalize_scalar(s, pos, len, upper, &b);
+
+    if (b.first >= b.end) {
+        return (span_t) { s, 0 };
+    }
+
+    return (span_t) { s + b.first, b.end - b.first };
+}
+
+
+/* Normalize string */
+size_t str_normalize(char **s, lettercase_t lettercase)
+{
+    span_t span = str_normalize_span(*s, strlen(*s), lettercase);
+
+    if (span.s != *s) {
+        memmove(*s, span.s, span.len);
+    }
+    (*s)[span.len] = '\0';
+
+    return span.len;
+}
+
+
+/* Initializes a set of characters */
+void charset_init(charset_t *set, const char *chars, size_t len)
+{
+    uint16_t groups[8];     /* Low nibbles of every group */
+    size_t ngroups = 0;
+
+    memset(set, 0, sizeof(charset_t));
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t c = chars[i];
+        set->bits[c >> 3] |= 1 << (c & 7);
     }
-    str_trim(*s);
+
+    /* Bytes with the same high nibble and the same low nibbles go to
+     * the same group, and there can be only 8 groups */
+    set->vector = true;
+    for (size_t h = 0; h < 16; ++h) {
+        uint16_t lows = 0;
+        size_t g;
+
+        for (size_t l = 0; l < 16; ++l) {
+            if (charset_has(set, h << 4 | l)) {
+                lows |= 1 << l;
+            }
+        }
+        if (!lows) {
+            continue;
+        }
+        for (g = 0; g < ngroups && groups[g] != lows; ++g) {
+            ;
+        }
+        if (g == ngroups) {
+            if (ngroups == 8) {
+                set->vector = false;
+                return;
+            }
+            groups[ngroups++] = lows;
+        }
+        set->hi[h] |= 1 << g;
+        for (size_t l = 0; l < 16; ++l) {
+            if (lows >> l & 1) {
+                set->lo[l] |= 1 << g;
+            }
+        }
+    }
+}
+
+
+#ifdef STR_SIMD
+/* Finds the first byte in (or not in) a set, 16 bytes at a time,
+ * leaving the position of the first byte not checked if not found */
+__attribute__((target("ssse3")))
+static bool str_scan_ssse3(const charset_t *set, const char *s,
+                           size_t *pos, size_t len, bool in)
+{
+    const __m128i lo = _mm_loadu_si128((const __m128i *) set->lo);
+    const __m128i hi = _mm_loadu_si128((const __m128i *) set->hi);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; *pos + 16 <= len; *pos += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (s + *pos));
+        __m128i l = _mm_shuffle_epi8(lo, _mm_and_si128(v, nibble));
+        __m128i h = _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(v, 4),
+                                                       nibble));
+        uint32_t out = _mm_movemask_epi8(
+                           _mm_cmpeq_epi8(_mm_and_si128(l, h), zero));
+        uint32_t mask = in ? out : ~out & 0xffff;
+
+        if (mask) {
+            *pos += __builtin_ctz(mask);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/* Finds the first byte in (or not in) a set, 32 bytes at a time */
+__attribute__((target("avx2")))
+static bool str_scan_avx2(const charset_t *set, const char *s,
+                          size_t *pos, size_t len, bool in)
+{
+    const __m256i lo = _mm256_broadcastsi128_si256(
+                           _mm_loadu_si128((const __m128i *) set->lo));
+    const __m256i hi = _mm256_broadcastsi128_si256(
+                           _mm_loadu_si128((const __m128i *) set->hi));
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+
+    for (; *pos + 32 <= len; *pos += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (s + *pos));
+        __m256i l = _mm256_shuffle_epi8(lo, _mm256_and_si256(v, nibble));
+        __m256i h = _mm256_shuffle_epi8(hi, _mm256_and_si256(
+                                                _mm256_srli_epi16(v, 4),
+                                                nibble));
+        uint32_t out = _mm256_movemask_epi8(
+                           _mm256_cmpeq_epi8(_mm256_and_si256(l, h), zero));
+        uint32_t mask = in ? out : ~out;
+
+        if (mask) {
+            *pos += __builtin_ctz(mask);
+            return true;
+        }
+    }
+
+    return false;
+}
+#endif
+
+
+/* Finds the first byte of a string in the set, or not in the set if
+ * 'in' is true, since that's the end of a chunk of bytes in the set.
+ * The first bytes are checked one by one, as most chunks are short and
+ * then it's not worth to prepare the vectors */
+static size_t str_scan(const charset_t *set, const char *s, size_t len,
+                       bool in)
+{
+    size_t pos = 0;
+
+    for (; pos < len && pos < STR_SCAN_SHORT; ++pos) {
+        if (charset_has(set, s[pos]) != in) {
+            return pos;
+        }
+    }
+
+#ifdef STR_SIMD
+    if (set->vector) {
+        if (len >= 32 && __builtin_cpu_supports("avx2") &&
+                str_scan_avx2(set, s, &pos, len, in)) {
+            return pos;
+        }
+        if (len - pos >= 16 && __builtin_cpu_supports("ssse3") &&
+                str_scan_ssse3(set, s, &pos, len, in)) {
+            return pos;
+        }
+    }
+#endif
+    while (pos < len && charset_has(set, s[pos]) == in) {
+        ++pos;
+    }
+
+    return pos;
+}
+
+
+/* Length of the initial chunk made of characters in the set */
+size_t str_span_in(const charset_t *set, const char *s, size_t len)
+{
+    return str_scan(set, s, len, true);
+}
+
+
+/* Length of the initial chunk made of characters not in the set */
+size_t str_span_out(const charset_t *set, const char *s, size_t len)
+{
+    return str_scan(set, s, len, false);
+}
+
+
+/* Gets the next chunk of a string between delimiters */
+bool str_iter_next(str_iter_t *it, span_t *span)
+{
+    it->cursor += str_span_in(it->delims, it->cursor, it->end - it->cursor);
+    if (it->cursor == it->end) {
+        return false;
+    }
+
+    span->s = it->cursor;
+    span->len = str_span_out(it->delims, it->cursor, it->end - it->cursor);
+    it->cursor += span->len;
+
+    return true;
 }
 
 
@@ -131,4 +461,3 @@ char *str_alloc_cpy(const char *src)
 
     return NULL;
 }
-
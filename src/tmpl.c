@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file tmpl.c
+ *
+ * @brief Message templates implementation
+ *
+ * The template is parsed twice: the first time only counts the
+ * segments and the bytes of literal text, so the template, its
+ * segments and its text take only two allocations.
+ */
+
+/* System includes */
+#include <stdbool.h>    /* bool, true, false */
+#include <stdio.h>      /* snprintf */
+#include <stdlib.h>     /* malloc, free */
+#include <string.h>     /* strchr, strlen, strncmp */
+
+/* Local includes */
+#include <cmd.h>
+#include <flag.h>
+#include <item.h>
+#include <printer.h>
+#include <qltys.h>
+#include <tmpl.h>
+
+
+/* Name of every placeholder */
+static const struct {
+    const char *name;
+    tmpl_seg_type_t type;
+} placeholders[] = {
+    { "kname", TMPL_KNAME },
+    { "uname", TMPL_UNAME },
+    { "desc", TMPL_DESC },
+    { "qty", TMPL_QTY },
+    { "flag", TMPL_FLAG },
+    { "action", TMPL_ACTION },
+    { "mode", TMPL_MODE },
+    { "number", TMPL_NUMBER },
+    { "quality", TMPL_QUALITY },
+    { "dobj", TMPL_DOBJ },
+    { "iobj", TMPL_IOBJ },
+    { "unknown", TMPL_UNKNOWN },
+};
+
+
+/* Kind of a placeholder by its name, TMPL_TEXT if there's none */
+static tmpl_seg_type_t tmpl_placeholder(const char *name, size_t len)
+{
+    for (size_t i = 0; i < sizeof(placeholders) / sizeof(*placeholders);
+            ++i) {
+        if (strlen(placeholders[i].name) == len &&
+                strncmp(placeholders[i].name, name, len) == 0) {
+            return placeholders[i].type;
+        }
+    }
+
+    return TMPL_TEXT;
+}
+
+
+/* Parses a template, counting the segments and the bytes of text, and
+ * filling the template too if there's one */
+static bool tmpl_parse(const char *text, tmpl_t *tmpl, size_t *nsegs,
+                       size_t *nbytes)
+{
+    size_t segs = 0;
+    size_t bytes = 0;
+    bool in_text = false;   /* a literal segment is open */
+
+    for (const char *c = text; *c; ) {
+        tmpl_seg_type_t type;
+        const char *end;
+
+        if ((c[0] == '{' && c[1] == '{') || (c[0] == '}' && c[1] == '}') ||
+                (c[0] != '{' && c[0] != '}')) {
+            if (!in_text) {
+                if (tmpl) {
+                    tmpl->segs[segs] =
+                        (tmpl_seg_t) { TMPL_TEXT, tmpl->text + bytes, 0 };
+                }
+                segs++;
+                in_text = true;
+            }
+            if (tmpl) {
+                tmpl->text[bytes] = c[0];
+                tmpl->segs[segs - 1].len++;
+            }
+            bytes++;
+            c += (c[0] == '{' || c[0] == '}') ? 2 : 1;
+            continue;
+        }
+
+        if (c[0] == '}' || !(end = strchr(c, '}')) ||
+                (type = tmpl_placeholder(c + 1, end - c - 1)) == TMPL_TEXT) {
+            return false;
+        }
+        if (tmpl) {
+            tmpl->segs[segs] = (tmpl_seg_t) { type, NULL, 0 };
+        }
+        segs++;
+        in_text = false;
+        c = end + 1;
+    }
+    *nsegs = segs;
+    *nbytes = bytes;
+
+    return true;
+}
+
+
+/* Parses a template */
+tmpl_t *tmpl_init(const char *text)
+{
+    tmpl_t *tmpl;
+    size_t segs;
+    size_t bytes;
+
+    if (!text || !tmpl_parse(text, NULL, &segs, &bytes)) {
+        return NULL;
+    }
+
+    if (!(tmpl = malloc(sizeof(tmpl_t) + sizeof(tmpl_seg_t) * segs))) {
+        return NULL;
+    }
+    if (!(tmpl->text = malloc(bytes + 1))) {
+        free(tmpl);
+        return NULL;
+    }
+    tmpl_parse(text, tmpl, &tmpl->len, &bytes);
+    tmpl->text[bytes] = '\0';
+
+    return tmpl;
+}
+
+
+/* Frees allocated memory */
+void tmpl_destroy(tmpl_t *tmpl)
+{
+    if (tmpl) {
+        free(tmpl->text);
+        free(tmpl);
+    }
+}
+
+
+/* Writes a string into the printer, if there's one */
+static int tmpl_str(printer_t *printer, const char *s)
+{
+    return s ? printer_write(printer, s, strlen(s)) : 0;
+}
+
+
+/* Writes a word of a command for a placeholder */
+static int tmpl_word(printer_t *printer, const cmdv_t *cmd,
+                     tmpl_seg_type_t type)
+{
+    span_t word;
+
+    switch (type) {
+        case TMPL_ACTION:
+            word = cmd->action.span;
+            break;
+
+        case TMPL_MODE:
+            word = cmd->mode.span;
+            break;
+
+        case TMPL_NUMBER:
+            word = cmd->quantity.span;
+            break;
+
+        case TMPL_QUALITY:
+            word = cmd->quality.span;
+            break;
+
+        case TMPL_DOBJ:
+            word = cmd->dobj.span;
+            break;
+
+        case TMPL_IOBJ:
+            word = cmd->iobj.span;
+            break;
+
+        default:
+            word = cmd->unknown;
+            break;
+    }
+
+    return word.len ? printer_write(printer, word.s, word.len) : 0;
+}
+
+
+/* Writes the text of a flag, with its state in the item */
+static int tmpl_flag(printer_t *printer, const tmpl_args_t *args)
+{
+    const flag_t *flag = args->flag;
+
+    if (!flag || !args->item || !qltys_has_flag(args->item->qltys, flag)) {
+        return 0;
+    }
+
+    return tmpl_str(printer, qltys_state(args->item->qltys, flag) ?
+                             flag->yes : flag->no);
+}
+
+
+/* Prints a template */
+int tmpl_print(printer_t *printer, const tmpl_t *tmpl,
+               const tmpl_args_t *args)
+{
+    const lingo_t *lingo = args && args->item ? args->item->lingo : NULL;
+    const cmdv_t *cmd = args ? args->cmd : NULL;
+    int total = 0;
+
+    if (!printer || !tmpl) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < tmpl->len; ++i) {
+        const tmpl_seg_t *seg = &tmpl->segs[i];
+        char qty[24];
+        int n = 0;
+
+        switch (seg->type) {
+            case TMPL_TEXT:
+                n = printer_write(printer, seg->s, seg->len);
+                break;
+
+            case TMPL_KNAME:
+                n = lingo ? tmpl_str(printer, lingo->kname) : 0;
+                break;
+
+            case TMPL_UNAME:
+                n = lingo ? tmpl_str(printer, lingo->uname ? lingo->uname :
+                                              lingo->kname) : 0;
+                break;
+
+            case TMPL_DESC:
+                n = lingo ? tmpl_str(printer, lingo->desc) : 0;
+                break;
+
+            case TMPL_QTY:
+                if (args) {
+                    n = snprintf(qty, sizeof(qty), "%ld", args->qty);
+                    n = printer_write(printer, qty, n);
+                }
+                break;
+
+            case TMPL_FLAG:
+                n = args ? tmpl_flag(printer, args) : 0;
+                break;
+
+            case TMPL_ACTION:
+            case TMPL_MODE:
+            case TMPL_NUMBER:
+            case TMPL_QUALITY:
+            case TMPL_DOBJ:
+            case TMPL_IOBJ:
+            case TMPL_UNKNOWN:
+                n = cmd ? tmpl_word(printer, cmd, seg->type) : 0;
+                break;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        total += n;
+    }
+
+    return total;
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file tokenizer.c
+ *
+ * @brief Tokenizer implementation
+ *
+ * Only the bytes that appear in some word of the lexicon get a class of
+ * their own; the rest of non delimiters share the same class, that
+ * always leads to the dead state.  This keeps the transition table as
+ * small as the alphabet of the lexicon.
+ */
+
+/* System includes */
+#include <ctype.h>      /* tolower */
+#include <stdbool.h>    /* bool, true, false */
+#include <stdint.h>     /* uint32_t */
+#include <stdlib.h>     /* calloc, realloc, free */
+#include <string.h>     /* memset */
+
+/* Local includes */
+#include <lexicon.h>
+#include <tokenizer.h>
+
+#define TOKENIZER_DELIM  (0)    /**< Class of the delimiters */
+#define TOKENIZER_OTHER  (1)    /**< Class of bytes not in the lexicon */
+#define TOKENIZER_DEAD   (0)    /**< State with no way out */
+#define TOKENIZER_START  (1)    /**< Initial state */
+
+
+/* Adds a new state, with every transition to the dead state */
+static uint32_t tokenizer_new_state(tokenizer_t *tokenizer)
+{
+    void *p;
+
+    if (tokenizer->nstates == tokenizer->cap) {
+        size_t cap = tokenizer->cap * 2;
+        if (!(p = realloc(tokenizer->trans,
+                          sizeof(uint32_t) * cap * tokenizer->nclasses))) {
+            return TOKENIZER_DEAD;
+        }
+        tokenizer->trans = p;
+        if (!(p = realloc(tokenizer->accept, sizeof(uint32_t) * cap))) {
+            return TOKENIZER_DEAD;
+        }
+        tokenizer->accept = p;
+        tokenizer->cap = cap;
+    }
+
+    memset(tokenizer->trans + tokenizer->nstates * tokenizer->nclasses, 0,
+           sizeof(uint32_t) * tokenizer->nclasses);
+    tokenizer->accept[tokenizer->nstates] = 0;
+
+    return tokenizer->nstates++;
+}
+
+
+/* Builds a tokenizer for all words in a lexicon */
+tokenizer_t *tokenizer_init(const lexicon_t *lexicon, const char *delims)
+{
+    tokenizer_t *tokenizer;
+
+    if (!lexicon || !(tokenizer = calloc(1, sizeof(tokenizer_t)))) {
+        return NULL;
+    }
+    tokenizer->lexicon = lexicon;
+
+    /* Classes: one for each byte used by the lexicon */
+    tokenizer->nclasses = TOKENIZER_OTHER + 1;
+    for (size_t i = 0; i < lexicon_len(lexicon); ++i) {
+        const lexentry_t *entry = &lexicon->entries[i];
+        const unsigned char *word =
+            (const unsigned char *) lexicon_word(lexicon, entry);
+        for (size_t j = 0; j < entry->len; ++j) {
+            if (!tokenizer->classes[word[j]] && tokenizer->nclasses < 256) {
+                tokenizer->classes[word[j]] = tokenizer->nclasses++;
+            }
+        }
+    }
+    for (int c = 0; c < 256; ++c) {
+        if (!tokenizer->classes[c]) {
+            uint8_t lower = isupper(c) ? tokenizer->classes[tolower(c)] : 0;
+            tokenizer->classes[c] = lower ? lower : TOKENIZER_OTHER;
+        }
+    }
+    for (; delims && *delims; ++delims) {
+        tokenizer->classes[(unsigned char) *delims] = TOKENIZER_DELIM;
+    }
+    tokenizer->classes[0] = TOKENIZER_DELIM;
+    tokenizer_init_delims(tokenizer);
+
+    /* States: the trie of every word */
+    tokenizer->cap = 64;
+    tokenizer->trans = malloc(sizeof(uint32_t) * tokenizer->cap *
+                              tokenizer->nclasses);
+    tokenizer->accept = malloc(sizeof(uint32_t) * tokenizer->cap);
+    if (!tokenizer->trans || !tokenizer->accept ||
+            tokenizer_new_state(tokenizer) != TOKENIZER_DEAD ||
+            tokenizer_new_state(tokenizer) != TOKENIZER_START) {
+        tokenizer_destroy(tokenizer);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < lexicon_len(lexicon); ++i) {
+        const lexentry_t *entry = &lexicon->entries[i];
+        const unsigned char *word =
+            (const unsigned char *) lexicon_word(lexicon, entry);
+        uint32_t state = TOKENIZER_START;
+
+        for (size_t j = 0; j < entry->len && state != TOKENIZER_DEAD; ++j) {
+            uint8_t cls = tokenizer->classes[word[j]];
+            uint32_t *next;
+
+            if (cls == TOKENIZER_DELIM || cls == TOKENIZER_OTHER) {
+                /* unreachable word */
+                state = TOKENIZER_DEAD;
+                break;
+            }
+            next = &tokenizer->trans[state * tokenizer->nclasses + cls];
+            if (*next == TOKENIZER_DEAD) {
+                uint32_t new_state = tokenizer_new_state(tokenizer);
+                if (new_state == TOKENIZER_DEAD) {
+                    tokenizer_destroy(tokenizer);
+                    return NULL;
+                }
+                /* 'trans' may have been moved by 'realloc' */
+                tokenizer->trans[state * tokenizer->nclasses + cls] =
+                    new_state;
+                state = new_state;
+            } else {
+                state = *next;
+            }
+        }
+        if (state != TOKENIZER_DEAD && !tokenizer->accept[state]) {
+            tokenizer->accept[state] = i + 1;
+        }
+    }
+
+    return tokenizer;
+}
+
+
+/* Sets the delimiters of a tokenizer from its classes */
+void tokenizer_init_delims(tokenizer_t *tokenizer)
+{
+    char delims[256];
+    size_t len = 0;
+
+    for (int c = 0; c < 256; ++c) {
+        if (tokenizer->classes[c] == TOKENIZER_DELIM) {
+            delims[len++] = c;
+        }
+    }
+    charset_init(&tokenizer->delims, delims, len);
+}
+
+
+/* Frees allocated memory */
+void tokenizer_destroy(tokenizer_t *tokenizer)
+{
+    free(tokenizer->trans);
+    free(tokenizer->accept);
+    free(tokenizer);
+}
+
+
+/* Gets the next word of a sentence */
+bool tokenizer_next(const tokenizer_t *tokenizer, const char **cursor,
+                    const char *end, token_t *token)
+{
+    const unsigned char *p = (const unsigned char *) *cursor;
+    const unsigned char *e = (const unsigned char *) end;
+    const unsigned char *start;
+    uint32_t state = TOKENIZER_START;
+    uint8_t cls;
+
+    /* Skip delimiters */
+    while (p < e && tokenizer->classes[*p] == TOKENIZER_DELIM) {
+        ++p;
+    }
+    if (p == e) {
+        *cursor = end;
+        return false;
+    }
+
+    /* Walk the word, and once it can't be in the lexicon, skip the rest
+     * of it many bytes at a time */
+    start = p;
+    while (p < e && (cls = tokenizer->classes[*p]) != TOKENIZER_DELIM) {
+        state = tokenizer->trans[state * tokenizer->nclasses + cls];
+        ++p;
+        if (state == TOKENIZER_DEAD) {
+            p += str_span_out(&tokenizer->delims, (const char *) p, e - p);
+            break;
+        }
+    }
+
+    token->span.s = (const char *) start;
+    token->span.len = p - start;
+    token->entry = tokenizer->accept[state];
+    token->lex = token->entry
+               ? (lexeme_t) tokenizer->lexicon->entries[token->entry - 1].lex
+               : LEX_UNK;
+    *cursor = (const char *) p;
+
+    return true;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file turn.c
+ *
+ * @brief Handling of a line of input implementation
+ */
+
+/* System includes */
+#include <stdbool.h>    /* bool, true, false */
+#include <string.h>     /* strlen */
+
+/* Local includes */
+#include <arena.h>
+#include <parser.h>
+#include <printer.h>
+#include <strops.h>
+#include <turn.h>
+
+
+/* Initializes the state of a player in place */
+void turn_init_at(turn_t *turn, printer_t *out)
+{
+    turn->out = out;
+    turn->count = 0;
+    turn->quit = false;
+}
+
+
+/* Handles a line of input */
+int turn_line(turn_t *turn, const char *line, size_t len)
+{
+    arena_t *arena = parser_turn();
+    char *sentence;
+    char *s;
+    size_t n;
+    int ret_val;
+
+    if (!arena || !(sentence = arena_strndup(arena, line, len))) {
+        return -2;
+    }
+
+    /* The printer of the parser is set on every turn, because the
+     * sessions of a server take turns on the same thread */
+    parser_set_printer(turn->out);
+    s = sentence;
+    n = str_normalize_l(&s);
+    if (streq(s, TURN_QUIT)) {
+        turn->quit = true;
+    }
+    ret_val = parse_normalized(s, n);
+    turn->count++;
+    parser_end_turn();
+
+    return ret_val;
+}
+
+
+/* Adds the prompt to the output of a player */
+void turn_prompt(turn_t *turn)
+{
+    printer_write(turn->out, TURN_PROMPT, strlen(TURN_PROMPT));
+}
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file widx.c
+ *
+ * @brief Inverted index of words implementation
+ *
+ * A word whose list becomes empty keeps its entry, as the words are
+ * few and they tend to be used again, so there's nothing to remove
+ * from the table.  New items have the greatest identifiers, so adding
+ * to a list is usually appending to it.
+ */
+
+/* System includes */
+#include <stdbool.h>    /* bool, true, false */
+#include <stdint.h>     /* uint32_t */
+#include <stdlib.h>     /* calloc, realloc, free */
+#include <string.h>     /* memmove */
+
+/* Local includes */
+#include <atom.h>
+#include <widx.h>
+
+#define WIDX_MIN_CAP  (64)  /**< Initial size of the table */
+#define WIDX_GALLOP   (16)  /**< Ratio of lengths to search, not merge */
+
+
+/* Entry of the table where a word should be */
+static inline size_t widx_hash(const widx_t *widx, atom_t atom)
+{
+    uint32_t h = atom * 2654435769u;
+
+    return (h ^ (h >> 16)) & (widx->cap - 1);
+}
+
+
+/* Entry of a word, or the empty entry where it would be */
+static size_t widx_slot(const widx_t *widx, atom_t atom)
+{
+    size_t pos = widx_hash(widx, atom);
+
+    while (widx->lists[pos].atom && widx->lists[pos].atom != atom) {
+        pos = (pos + 1) & (widx->cap - 1);
+    }
+
+    return pos;
+}
+
+
+/* List of a word, NULL if it has no entry */
+static widx_list_t *widx_find(const widx_t *widx, atom_t atom)
+{
+    widx_list_t *list;
+
+    if (widx->cap == 0 || atom == ATOM_NONE) {
+        return NULL;
+    }
+    list = &widx->lists[widx_slot(widx, atom)];
+
+    return list->atom ? list : NULL;
+}
+
+
+/* Doubles the table */
+static bool widx_grow(widx_t *widx)
+{
+    size_t cap = widx->cap ? widx->cap * 2 : WIDX_MIN_CAP;
+    widx_list_t *old = widx->lists;
+    size_t old_cap = widx->cap;
+
+    if (!(widx->lists = calloc(cap, sizeof(widx_list_t)))) {
+        widx->lists = old;
+        return false;
+    }
+    widx->cap = cap;
+    for (size_t i = 0; i < old_cap; ++i) {
+        if (old[i].atom) {
+            widx->lists[widx_slot(widx, old[i].atom)] = old[i];
+        }
+    }
+    free(old);
+
+    return true;
+}
+
+
+/* First position of a list not less than an identifier */
+static size_t widx_lower(const uint32_t *ids, size_t len, uint32_t id)
+{
+    size_t lo = 0;
+    size_t hi = len;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (ids[mid] < id) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+
+/* Initializes an empty index */
+void widx_init_at(widx_t *widx)
+{
+    widx->lists = NULL;
+    widx->cap = 0;
+    widx->len = 0;
+}
+
+
+/* Frees the memory used by an index */
+void widx_destroy_at(widx_t *widx)
+{
+    for (size_t i = 0; i < widx->cap; ++i) {
+        free(widx->lists[i].ids);
+    }
+    free(widx->lists);
+    widx_init_at(widx);
+}
+
+
+/* Adds an identifier to the list of a word */
+bool widx_add(widx_t *widx, atom_t atom, uint32_t id)
+{
+    widx_list_t *list;
+    size_t pos;
+
+    if (atom == ATOM_NONE) {
+        return false;
+    }
+    if (!(list = widx_find(widx, atom))) {
+        /* Keep the table at most half full */
+        if ((widx->len + 1) * 2 > widx->cap && !widx_grow(widx)) {
+            return false;
+        }
+        list = &widx->lists[widx_slot(widx, atom)];
+        list->atom = atom;
+        widx->len++;
+    }
+
+    pos = list->len > 0 && list->ids[list->len - 1] < id ?
+          list->len : widx_lower(list->ids, list->len, id);
+    if (pos < list->len && list->ids[pos] == id) {
+        return false;
+    }
+    if (list->len == list->cap) {
+        uint32_t cap = list->cap ? list->cap * 2 : 4;
+        uint32_t *ids = realloc(list->ids, sizeof(uint32_t) * cap);
+        if (!ids) {
+            return false;
+        }
+        list->ids = ids;
+        list->cap = cap;
+    }
+    memmove(&list->ids[pos + 1], &list->ids[pos],
+            sizeof(uint32_t) * (list->len - pos));
+    list->ids[pos] = id;
+    list->len++;
+
+    return true;
+}
+
+
+/* Removes an identifier from the list of a word */
+bool widx_rem(widx_t *widx, atom_t atom, uint32_t id)
+{
+    widx_list_t *list;
+    size_t pos;
+
+    if (!(list = widx_find(widx, atom))) {
+        return false;
+    }
+    pos = widx_lower(list->ids, list->len, id);
+    if (pos == list->len || list->ids[pos] != id) {
+        return false;
+    }
+    memmove(&list->ids[pos], &list->ids[pos + 1],
+            sizeof(uint32_t) * (list->len - pos - 1));
+    list->len--;
+
+    return true;
+}
+
+
+/* Gets the list of a word */
+const uint32_t *widx_get(const widx_t *widx, atom_t atom, size_t *len)
+{
+    const widx_list_t *list = widx_find(widx, atom);
+
+    *len = list ? list->len : 0;
+
+    return *len > 0 ? list->ids : NULL;
+}
+
+
+/* Intersects two sorted lists */
+size_t widx_intersect(const uint32_t *a, size_t na,
+                      const uint32_t *b, size_t nb, uint32_t *out)
+{
+    size_t n = 0;
+    size_t i = 0;
+    size_t j = 0;
+
+    if (na > nb) {
+        return widx_intersect(b, nb, a, na, out);
+    }
+
+    /* Search the few identifiers of a short list in the long one */
+    if (na * WIDX_GALLOP < nb) {
+        for (i = 0; i < na && j < nb; ++i) {
+            j += widx_lower(b + j, nb - j, a[i]);
+            if (j < nb && b[j] == a[i]) {
+                out[n++] = a[i];
+            }
+        }
+        return n;
+    }
+
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) {
+            i++;
+        } else if (a[i] > b[j]) {
+            j++;
+        } else {
+            out[n++] = a[i];
+            i++;
+            j++;
+        }
+    }
+
+    return n;
+}
@@ -15,16 +15,121 @@
  * @file wset.c
  *
  * @brief Word set operations implementation
+ *
+ * A small set is just an array of atoms, searched one by one.  A big
+ * set keeps the atoms in a hash table with open addressing and linear
+ * probing.  Removing shifts back the atoms that follow in the same run
+ * instead of leaving tombstones, so the table never degrades.
  */
 
 /* System includes */
 #include <stdbool.h>    /* bool, true, false */
-#include <stdlib.h>     /* malloc, realloc, free */
+#include <stdint.h>     /* uint32_t */
+#include <stdlib.h>     /* malloc, calloc, free */
+#include <string.h>     /* memcpy */
 
 /* Local includes */
+#include <atom.h>
 #include <strops.h>
 #include <wset.h>
 
+#define WSET_MIN_CAP  (2 * WSET_SMALL)  /**< Initial size of the table */
+
+/**
+ * @brief Macro that evaluates to @c true if the atoms are kept inside
+ *        the set
+ */
+#define wset_is_small(w)  ((w)->cap == 0)
+
+
+/* Slot where an atom should be */
+static inline size_t wset_hash(const wset_t *wset, atom_t atom)
+{
+    uint32_t h = atom * 2654435769u;
+
+    return (h ^ (h >> 16)) & (wset->cap - 1);
+}
+
+
+/* Slot of an atom, or the empty slot where it would be */
+static size_t wset_slot(const wset_t *wset, atom_t atom)
+{
+    size_t pos = wset_hash(wset, atom);
+
+    while (wset->words[pos] != ATOM_NONE && wset->words[pos] != atom) {
+        pos = (pos + 1) & (wset->cap - 1);
+    }
+
+    return pos;
+}
+
+
+/* Index of an atom in a small set, or the length if not there */
+static size_t wset_small_index(const wset_t *wset, atom_t atom)
+{
+    size_t i = 0;
+
+    while (i < wset->len && wset->small[i] != atom) {
+        ++i;
+    }
+
+    return i;
+}
+
+
+/* Changes the size of the table, placing every atom again */
+static bool wset_resize(wset_t *wset, size_t cap)
+{
+    atom_t small[WSET_SMALL];
+    atom_t *old;
+    size_t old_len;
+    atom_t *words;
+
+    if (!(words = calloc(cap, sizeof(atom_t)))) {
+        return false;
+    }
+    if (wset_is_small(wset)) {
+        memcpy(small, wset->small, sizeof(small));
+        old = small;
+        old_len = wset->len;
+    } else {
+        old = wset->words;
+        old_len = wset->cap;
+    }
+
+    wset->words = words;
+    wset->cap = cap;
+    for (size_t i = 0; i < old_len; ++i) {
+        if (old[i] != ATOM_NONE) {
+            wset->words[wset_slot(wset, old[i])] = old[i];
+        }
+    }
+    if (old != small) {
+        free(old);
+    }
+
+    return true;
+}
+
+
+/* Initializes an empty bag of words in place */
+void wset_init_at(wset_t *wset)
+{
+    wset->cap = 0;
+    wset->len = 0;
+    wset->bytes = 0;
+}
+
+
+/* Frees the memory of a bag of words initialized in place */
+void wset_destroy_at(wset_t *wset)
+{
+    if (!wset_is_small(wset)) {
+        free(wset->words);
+    }
+    wset_init_at(wset);
+}
+
 
 /* Create an empty bag of words */
 wset_t *wset_init(void)
@@ -34,12 +139,7 @@ wset_t *wset_init(void)
     if (!(wset = malloc(sizeof(wset_t)))) {
         return NULL;
     }
-    if (!(wset->words = malloc(sizeof(char *)))) {
-        return NULL;
-    }
-
-    wset->len = 0;
-    wset->bytes = 0;
+    wset_init_at(wset);
 
     return wset;
 }
@@ -48,81 +148,138 @@ wset_t *wset_init(void)
 /* Frees allocated memory */
 void wset_destroy(wset_t *wset, bool destroy_words)
 {
-    if (wset->words && destroy_words) {
-        for (size_t i = 0; i < wset->len; ++i) {
-            free(wset->words[i]);
-        }
-    }
-    free(wset->words);
+    (void) destroy_words;   /* the words belong to the table of atoms */
+
+    wset_destroy_at(wset);
     free(wset);
 }
 
 
+/* Checks if the word of an atom is contained in the set of words */
+bool wset_has_atom(wset_t *wset, atom_t atom)
+{
+    if (!wset || wset->len == 0 || atom == ATOM_NONE) {
+        return false;
+    }
+    if (wset_is_small(wset)) {
+        return wset_small_index(wset, atom) < wset->len;
+    }
+
+    return wset->words[wset_slot(wset, atom)] == atom;
+}
+
+
 /* Checks if a word is contained in the set of words */
 bool wset_has_word(wset_t *wset, const char *word)
 {
-    return str_in_array(word, (const char **) wset->words, wset->len);
+    atom_t atom;
+
+    if (!word || (atom = atom_find_str(word)) == ATOM_NONE) {
+        return false;
+    }
+
+    return wset_has_atom(wset, atom);
+}
+
+
+/* Adds the word of an atom to the set of words */
+bool wset_add_atom(wset_t *wset, atom_t atom)
+{
+    size_t pos;
+
+    if (!wset || atom == ATOM_NONE || wset_has_atom(wset, atom)) {
+        return false;
+    }
+
+    if (wset_is_small(wset) && wset->len < WSET_SMALL) {
+        wset->small[wset->len] = atom;
+    } else {
+        /* Keep the table at most 3/4 full */
+        if ((wset->len + 1) * 4 > wset->cap * 3 &&
+                !wset_resize(wset, wset->cap ? wset->cap * 2
+                                             : WSET_MIN_CAP)) {
+            return false;
+        }
+        pos = wset_slot(wset, atom);
+        wset->words[pos] = atom;
+    }
+    wset->len++;
+    wset->bytes += atom_len(atom);
+
+    return true;
 }
 
 
 /* Adds a new word to the set of words */
 bool wset_add(wset_t *wset, const char *word)
 {
-    if (!word || str_is_empty(word) || !wset || wset_has_word(wset, word)) {
+    if (!word || str_is_empty(word) || !wset) {
         return false;
     }
 
-    wset->words = realloc(wset->words, sizeof(char *) * (wset->len + 1));
-    wset->words[wset->len] = realloc(wset->words[wset->len],
-                                     sizeof(char) * (strlen(word) + 1));
+    return wset_add_atom(wset, atom_intern_str(word));
+}
+
 
-    if (!wset->words[wset->len]) {
+/* Removes an atom from the table of a big set */
+static bool wset_table_rem(wset_t *wset, atom_t atom)
+{
+    size_t mask = wset->cap - 1;
+    size_t pos = wset_slot(wset, atom);
+
+    if (wset->words[pos] != atom) {
         return false;
     }
-    str_cpy(wset->words[wset->len], word);
-    wset->bytes += strlen(word);
-    wset->len++;
+
+    /* Shift back every atom of the run that would be unreachable */
+    for (size_t next = (pos + 1) & mask; wset->words[next] != ATOM_NONE;
+            next = (next + 1) & mask) {
+        size_t home = wset_hash(wset, wset->words[next]);
+        if (((next - home) & mask) >= ((next - pos) & mask)) {
+            wset->words[pos] = wset->words[next];
+            pos = next;
+        }
+    }
+    wset->words[pos] = ATOM_NONE;
 
     return true;
 }
 
 
-/* Removes a word from the set of words */
-bool wset_rem(wset_t *wset, const char *word)
+/* Removes the word of an atom from the set of words */
+bool wset_rem_atom(wset_t *wset, atom_t atom)
 {
-    if (!word || str_is_empty(word) || !wset ||
-            !wset_has_word(wset, word) || wset->len == 0) {
+    if (!wset || wset->len == 0 || atom == ATOM_NONE) {
         return false;
     }
 
-    for (size_t i = 0; i < wset->len; ++i) {
-        if (streq(wset->words[i], word)) {
-            for (size_t j = i; j < wset->len; ++j) {
-                wset->words[j] = wset->words[j+1];
-            }
-            // FIXME/BUG: Segfault when adding after removing!
-            // TODO: check 'realloc'
-/*
-            wset->words[i] = realloc(wset->words[i],
-                    sizeof(char *) * (wset->bytes - strlen(word)));
-            if (!wset->words[i]) {
-                return false;
-            }
-
-            wset->words = realloc(wset->words, sizeof(char **) * wset->len);
-            if (!wset->words) {
-                return false;
-            }
-*/
-            wset->bytes -= strlen(word);
-            wset->len--;
+    if (wset_is_small(wset)) {
+        size_t i = wset_small_index(wset, atom);
+        if (i == wset->len) {
+            return false;
         }
+        wset->small[i] = wset->small[wset->len - 1];
+    } else if (!wset_table_rem(wset, atom)) {
+        return false;
     }
+    wset->len--;
+    wset->bytes -= atom_len(atom);
 
     return true;
 }
 
 
+/* Removes a word from the set of words */
+bool wset_rem(wset_t *wset, const char *word)
+{
+    if (!word || str_is_empty(word)) {
+        return false;
+    }
+
+    return wset_rem_atom(wset, atom_find_str(word));
+}
+
+
 /* Replaces an old string in the set with a new one */
 bool wset_replace(wset_t *wset, const char *old, const char *new)
 {
@@ -133,8 +290,47 @@ bool wset_replace(wset_t *wset, const char *old, const char *new)
 /* Applies a function to every string on the set */
 void wset_map(wset_t *wset, void (*f)(char *))
 {
-    for (size_t i = 0; i < wset->len; ++i) {
-        f(wset->words[i]);
+    wset_t old = *wset;
+    const atom_t *atoms = wset_is_small(&old) ? old.small : old.words;
+    size_t len = wset_is_small(&old) ? old.len : old.cap;
+
+    /* The new set has the same room, as there can't be more atoms */
+    if (!wset_is_small(&old) &&
+            !(wset->words = calloc(old.cap, sizeof(atom_t)))) {
+        *wset = old;
+        return;
+    }
+    wset->len = 0;
+    wset->bytes = 0;
+
+    for (size_t i = 0; i < len; ++i) {
+        char *word;
+        atom_t atom;
+
+        if (atoms[i] == ATOM_NONE ||
+                !(word = str_alloc_cpy(atom_str(atoms[i])))) {
+            continue;
+        }
+        f(word);
+        atom = atom_intern_str(word);
+        free(word);
+        wset_add_atom(wset, atom);
+    }
+    if (!wset_is_small(&old)) {
+        free(old.words);
     }
 }
 
+
+/* Calls a function with every atom of the set */
+void wset_each(const wset_t *wset, void (*f)(atom_t, void *), void *data)
+{
+    const atom_t *atoms = wset_is_small(wset) ? wset->small : wset->words;
+    size_t len = wset_is_small(wset) ? wset->len : wset->cap;
+
+    for (size_t i = 0; i < len; ++i) {
+        if (atoms[i] != ATOM_NONE) {
+            f(atoms[i], data);
+        }
+    }
+}
@@ -0,0 +1,675 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file bench.c
+ *
+ * @brief Measures the throughput of the parser
+ *
+ * A synthetic corpus of imperative sentences is generated following
+ * the grammar of the parser (see README), with the words of its
+ * lexicon, and every sentence is parsed
+ * once per round by each function measured.  The time of every line is
+ * taken to get the latency percentiles.
+ *
+ * The corpus is also parsed with @e batch_parse, with a single thread
+ * and with several, a window of lines at once, to see how it scales;
+ * then the percentiles are of the time per line of every window.
+ *
+ * The results are written to the standard output as JSON or CSV, so
+ * they can be compared between releases.
+ *
+ * @code
+ * $ bench --lines 100000 --rounds 5 --format csv
+ * $ bench --write corpus.txt     # only write the corpus
+ * @endcode
+ */
+
+/* System includes */
+#include <getopt.h>     /* getopt_long */
+#include <stdbool.h>    /* bool, true, false */
+#include <stdint.h>     /* uint64_t */
+#include <stdio.h>      /* printf, fprintf, fopen, snprintf */
+#include <stdlib.h>     /* malloc, free, qsort, strtoul */
+#include <string.h>     /* memcpy, strcmp */
+#include <time.h>       /* clock_gettime */
+#include <unistd.h>     /* sysconf */
+
+/* Local includes */
+#include <array.h>
+#include <batch.h>
+#include <cmd.h>
+#include <parser.h>
+
+#define BENCH_LINES     (100000)    /**< Default number of lines */
+#define BENCH_ROUNDS    (3)         /**< Default number of rounds */
+#define BENCH_SEED      (2019)      /**< Default seed of the corpus */
+#define BENCH_LINE_MAX  (256)       /**< Maximum length of a line */
+#define BENCH_CLAUSES   (3)         /**< Maximum clauses in a line */
+#define BENCH_NAME_MAX  (32)        /**< Longest name of a benchmark */
+
+
+/* Words of a category */
+typedef struct {
+    const char **words;
+    size_t len;
+} words_t;
+
+
+/* Words of the corpus, by category, taken from the lexicon */
+static words_t verbs, adverbs, adjectives, numbers, articles, nouns,
+               pronouns, prepositions, conjunctions;
+
+/* Words that are in no lexicon */
+static const char *unknown_words[] =
+    { "xyzzy", "plugh", "wand", "lantern", };
+static words_t unknowns = { unknown_words, arr_len(unknown_words) };
+
+
+/* Lines of the corpus */
+typedef struct {
+    char *text;         /* Every line, null-terminated, one after another */
+    char *words;        /* Same as text, with a null after every word */
+    size_t *offsets;    /* Start of every line in text and words */
+    size_t *ntokens;    /* Words in every line */
+    size_t len;         /* Number of lines */
+    size_t tokens;      /* Words in the whole corpus */
+} corpus_t;
+
+
+/* Result of a benchmark */
+typedef struct {
+    const char *name;
+    size_t lines;
+    size_t tokens;
+    uint64_t total_ns;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+} result_t;
+
+
+/* Pseudo-random numbers (xorshift64*), always the same for a seed */
+static uint64_t bench_state;
+
+static size_t bench_rand(size_t n)
+{
+    bench_state ^= bench_state >> 12;
+    bench_state ^= bench_state << 25;
+    bench_state ^= bench_state >> 27;
+
+    return (bench_state * 2685821657736338717ull >> 32) % n;
+}
+
+#define bench_pick(w)  ((w).words[bench_rand((w).len)])
+#define bench_maybe(pct)  (bench_rand(100) < (pct))
+
+
+/* Current time, in nanoseconds */
+static inline uint64_t bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+
+/* Appends a word to a line */
+static void bench_word(char *line, size_t *len, size_t *ntokens,
+                       const char *word)
+{
+    size_t wlen = strlen(word);
+
+    if (*len + wlen + 1 >= BENCH_LINE_MAX) {
+        return;
+    }
+    if (*len) {
+        line[(*len)++] = ' ';
+    }
+    memcpy(line + *len, word, wlen + 1);
+    *len += wlen;
+    (*ntokens)++;
+}
+
+
+/* Writes a random sentence following the grammar:
+ *
+ *    <verb> [<pronoun>] [<adverb>] [<prep>] [<art>] [<num>] [<adj>]
+ *    <noun> [<conj> <sentence>]
+ */
+static size_t bench_sentence(char *line, size_t *ntokens)
+{
+    size_t clauses = 1 + bench_rand(BENCH_CLAUSES);
+    size_t len = 0;
+
+    *ntokens = 0;
+    line[0] = '\0';
+    for (size_t i = 0; i < clauses; ++i) {
+        if (i) {
+            bench_word(line, &len, ntokens, bench_pick(conjunctions));
+        }
+        bench_word(line, &len, ntokens, bench_pick(verbs));
+        if (bench_maybe(30)) {
+            bench_word(line, &len, ntokens, bench_pick(pronouns));
+        }
+        if (bench_maybe(30)) {
+            bench_word(line, &len, ntokens, bench_pick(adverbs));
+        }
+        if (bench_maybe(40)) {
+            bench_word(line, &len, ntokens, bench_pick(prepositions));
+        }
+        if (bench_maybe(50)) {
+            bench_word(line, &len, ntokens, bench_pick(articles));
+        }
+        if (bench_maybe(20)) {
+            bench_word(line, &len, ntokens, bench_pick(numbers));
+        }
+        if (bench_maybe(40)) {
+            bench_word(line, &len, ntokens, bench_pick(adjectives));
+        }
+        bench_word(line, &len, ntokens, bench_maybe(5) ? bench_pick(unknowns)
+                                                        : bench_pick(nouns));
+    }
+
+    return len;
+}
+
+
+/* Takes the words of every category from the lexicon of the parser */
+static int bench_words_init(void)
+{
+    static const struct {
+        words_t *words;
+        lexeme_t lex;
+    } categories[] = {
+        { &verbs, LEX_VERB },
+        { &adverbs, LEX_ADVERB },
+        { &adjectives, LEX_ADJ },
+        { &numbers, LEX_NUM },
+        { &articles, LEX_ART },
+        { &nouns, LEX_NOUN },
+        { &pronouns, LEX_PRONOUN },
+        { &prepositions, LEX_PREP },
+        { &conjunctions, LEX_CONJ },
+    };
+    const lexicon_t *lexicon = parser_lexicon();
+
+    for (size_t c = 0; c < arr_len(categories); ++c) {
+        words_t *w = categories[c].words;
+
+        if (!(w->words = malloc(sizeof(char *) * lexicon->len))) {
+            return 1;
+        }
+        w->len = 0;
+        for (size_t i = 0; i < lexicon->len; ++i) {
+            if (lexicon->entries[i].lex == categories[c].lex) {
+                w->words[w->len++] =
+                    lexicon_word(lexicon, &lexicon->entries[i]);
+            }
+        }
+        if (w->len == 0) {
+            return 1;   /* every category is needed */
+        }
+    }
+
+    return 0;
+}
+
+
+/* Frees the words of every category */
+static void bench_words_destroy(void)
+{
+    words_t *categories[] = { &verbs, &adverbs, &adjectives, &numbers,
+                              &articles, &nouns, &pronouns, &prepositions,
+                              &conjunctions, };
+
+    for (size_t c = 0; c < arr_len(categories); ++c) {
+        free(categories[c]->words);
+        categories[c]->words = NULL;
+    }
+}
+
+
+/* Generates the corpus */
+static int corpus_init(corpus_t *corpus, size_t lines, uint64_t seed)
+{
+    char line[BENCH_LINE_MAX];
+    size_t size = 0;
+    size_t cap = lines * 32;
+
+    bench_state = seed ? seed : BENCH_SEED;
+    corpus->len = lines;
+    corpus->tokens = 0;
+    corpus->words = NULL;
+    corpus->text = malloc(cap);
+    corpus->offsets = malloc(sizeof(size_t) * (lines + 1));
+    corpus->ntokens = malloc(sizeof(size_t) * lines);
+    if (!corpus->text || !corpus->offsets || !corpus->ntokens) {
+        return 1;
+    }
+
+    for (size_t i = 0; i < lines; ++i) {
+        size_t len = bench_sentence(line, &corpus->ntokens[i]);
+
+        if (size + len + 1 > cap) {
+            char *text;
+            cap = cap * 2 + len + 1;
+            if (!(text = realloc(corpus->text, cap))) {
+                return 1;
+            }
+            corpus->text = text;
+        }
+        corpus->offsets[i] = size;
+        memcpy(corpus->text + size, line, len + 1);
+        size += len + 1;
+        corpus->tokens += corpus->ntokens[i];
+    }
+    corpus->offsets[lines] = size;
+
+    /* Split the words of every line for 'lexeme_type' */
+    if (!(corpus->words = malloc(size))) {
+        return 1;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        corpus->words[i] = corpus->text[i] == ' ' ? '\0' : corpus->text[i];
+    }
+
+    return 0;
+}
+
+
+/* Frees the corpus */
+static void corpus_destroy(corpus_t *corpus)
+{
+    free(corpus->text);
+    free(corpus->words);
+    free(corpus->offsets);
+    free(corpus->ntokens);
+}
+
+
+/* Gets the line of the corpus */
+#define corpus_line(c, i)  ((c)->text + (c)->offsets[i])
+
+
+/* Functions measured, each one parses a single line */
+static void bench_lexeme_type(const corpus_t *corpus, size_t i, char *buf)
+{
+    const char *word = corpus->words + corpus->offsets[i];
+    volatile lexeme_t lex;
+
+    (void) buf;
+    for (size_t j = 0; j < corpus->ntokens[i]; ++j) {
+        lex = lexeme_type(word);
+        word += strlen(word) + 1;
+    }
+    (void) lex;
+}
+
+static void bench_parse_simple(const corpus_t *corpus, size_t i, char *buf)
+{
+    (void) corpus;
+    (void) i;
+    parse_simple(buf);
+}
+
+static void bench_parse_compound(const corpus_t *corpus, size_t i, char *buf)
+{
+    (void) corpus;
+    (void) i;
+    parse_compound(buf);
+}
+
+static void bench_parse_line(const corpus_t *corpus, size_t i, char *buf)
+{
+    cmdlist_t list;
+
+    (void) buf;
+    parse_line(corpus_line(corpus, i),
+               corpus->offsets[i + 1] - corpus->offsets[i] - 1, &list);
+}
+
+static const struct {
+    const char *name;
+    void (*f)(const corpus_t *, size_t, char *);
+} benchmarks[] = {
+    { "lexeme_type", bench_lexeme_type },
+    { "parse_simple", bench_parse_simple },
+    { "parse_compound", bench_parse_compound },
+    { "parse_line", bench_parse_line },
+};
+
+
+/* Compares two samples */
+static int bench_cmp(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+
+/* Runs a benchmark over the corpus */
+static void bench_run(const corpus_t *corpus, size_t b, size_t rounds,
+                      uint64_t *samples, result_t *result)
+{
+    char buf[BENCH_LINE_MAX];
+    size_t n = 0;
+
+    result->name = benchmarks[b].name;
+    result->lines = corpus->len * rounds;
+    result->tokens = corpus->tokens * rounds;
+    result->total_ns = 0;
+
+    /* Warm up caches and branch predictors */
+    for (size_t i = 0; i < corpus->len && i < 1000; ++i) {
+        strcpy(buf, corpus_line(corpus, i));
+        benchmarks[b].f(corpus, i, buf);
+    }
+
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < corpus->len; ++i) {
+            uint64_t start;
+
+            strcpy(buf, corpus_line(corpus, i));    /* parsing may write */
+            start = bench_now();
+            benchmarks[b].f(corpus, i, buf);
+            samples[n] = bench_now() - start;
+            result->total_ns += samples[n++];
+        }
+    }
+
+    qsort(samples, n, sizeof(uint64_t), bench_cmp);
+    result->p50_ns = samples[n * 50 / 100];
+    result->p99_ns = samples[n * 99 / 100];
+}
+
+
+/* Parses the corpus with a batch, a window of lines at once */
+static int bench_batch(const corpus_t *corpus, unsigned nthreads,
+                       size_t rounds, uint64_t *samples, result_t *result,
+                       char *name)
+{
+    span_t *lines = malloc(sizeof(span_t) * corpus->len);
+    cmdlist_t *lists = malloc(sizeof(cmdlist_t) * BATCH_WINDOW);
+    size_t n = 0;
+
+    if (!lines || !lists) {
+        free(lines);
+        free(lists);
+        return 1;
+    }
+    for (size_t i = 0; i < corpus->len; ++i) {
+        lines[i].s = corpus_line(corpus, i);
+        lines[i].len = corpus->offsets[i + 1] - corpus->offsets[i] - 1;
+    }
+
+    snprintf(name, BENCH_NAME_MAX, "batch_parse/%u", nthreads);
+    result->name = name;
+    result->lines = corpus->len * rounds;
+    result->tokens = corpus->tokens * rounds;
+    result->total_ns = 0;
+
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t first = 0; first < corpus->len; first += BATCH_WINDOW) {
+            size_t len = corpus->len - first < BATCH_WINDOW ?
+                         corpus->len - first : BATCH_WINDOW;
+            uint64_t start = bench_now();
+            uint64_t ns;
+
+            batch_parse(lines + first, len, lists, nthreads);
+            ns = bench_now() - start;
+            result->total_ns += ns;
+            samples[n++] = ns / len;
+        }
+    }
+
+    qsort(samples, n, sizeof(uint64_t), bench_cmp);
+    result->p50_ns = samples[n * 50 / 100];
+    result->p99_ns = samples[n * 99 / 100];
+    free(lines);
+    free(lists);
+
+    return 0;
+}
+
+
+/* Reads the number of threads, from 1 to BATCH_THREADS_MAX */
+static bool bench_threads(const char *s, unsigned *nthreads)
+{
+    char *end;
+    unsigned long n = strtoul(s, &end, 10);
+
+    if (*s < '0' || *s > '9' || *end != '\0' || n == 0 ||
+            n > BATCH_THREADS_MAX) {
+        return false;
+    }
+    *nthreads = (unsigned) n;
+
+    return true;
+}
+
+
+/* Writes the results */
+static void bench_print(const result_t *results, size_t len,
+                        const corpus_t *corpus, uint64_t seed, bool csv)
+{
+    if (csv) {
+        puts("name,lines,tokens,total_ns,ns_per_token,lines_per_sec,"
+             "p50_ns,p99_ns");
+    } else {
+        printf("{\n  \"corpus\": { \"lines\": %zu, \"tokens\": %zu, "
+               "\"seed\": %llu },\n  \"results\": [\n",
+               corpus->len, corpus->tokens, (unsigned long long) seed);
+    }
+
+    for (size_t i = 0; i < len; ++i) {
+        const result_t *r = &results[i];
+        double ns_token = r->tokens ? (double) r->total_ns / r->tokens : 0;
+        double lines_sec = r->total_ns ? r->lines * 1e9 / r->total_ns : 0;
+
+        if (csv) {
+            printf("%s,%zu,%zu,%llu,%.2f,%.0f,%llu,%llu\n",
+                   r->name, r->lines, r->tokens,
+                   (unsigned long long) r->total_ns, ns_token, lines_sec,
+                   (unsigned long long) r->p50_ns,
+                   (unsigned long long) r->p99_ns);
+        } else {
+            printf("    { \"name\": \"%s\", \"lines\": %zu, "
+                   "\"tokens\": %zu, \"total_ns\": %llu,\n"
+                   "      \"ns_per_token\": %.2f, \"lines_per_sec\": %.0f, "
+                   "\"p50_ns\": %llu, \"p99_ns\": %llu }%s\n",
+                   r->name, r->lines, r->tokens,
+                   (unsigned long long) r->total_ns, ns_token, lines_sec,
+                   (unsigned long long) r->p50_ns,
+                   (unsigned long long) r->p99_ns,
+                   i + 1 < len ? "," : "");
+        }
+    }
+
+    if (!csv) {
+        puts("  ]\n}");
+    }
+}
+
+
+/* Writes the corpus to a file */
+static int bench_write(const corpus_t *corpus, const char *path)
+{
+    FILE *fp;
+
+    if (!(fp = fopen(path, "w"))) {
+        perror(path);
+        return 1;
+    }
+    for (size_t i = 0; i < corpus->len; ++i) {
+        fprintf(fp, "%s\n", corpus_line(corpus, i));
+    }
+
+    return fclose(fp) != 0;
+}
+
+
+/* Shows how to use the program */
+static void usage(FILE *fp, const char *name)
+{
+    fprintf(fp, "Usage: %s [OPTION]...\n", name);
+    fprintf(fp, "  -n, --lines N       lines of the corpus (%d)\n",
+            BENCH_LINES);
+    fprintf(fp, "  -r, --rounds N      times every line is parsed (%d)\n",
+            BENCH_ROUNDS);
+    fprintf(fp, "  -s, --seed N        seed of the corpus (%d)\n",
+            BENCH_SEED);
+    fprintf(fp, "  -f, --format FMT    'json' or 'csv' (json)\n");
+    fprintf(fp, "  -l, --lexicon FILE  use the lexicon compiled in FILE\n");
+    fprintf(fp, "  -t, --threads N     threads of the batch (one per core)\n");
+    fprintf(fp, "  -w, --write FILE    write the corpus to FILE and exit\n");
+    fprintf(fp, "  -h, --help          show this help and exit\n");
+}
+
+
+/* Main entry */
+int main(int argc, char *argv[])
+{
+    static const struct option options[] = {
+        { "lines", required_argument, NULL, 'n' },
+        { "rounds", required_argument, NULL, 'r' },
+        { "seed", required_argument, NULL, 's' },
+        { "format", required_argument, NULL, 'f' },
+        { "lexicon", required_argument, NULL, 'l' },
+        { "threads", required_argument, NULL, 't' },
+        { "write", required_argument, NULL, 'w' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 },
+    };
+    result_t results[arr_len(benchmarks) + 2];
+    char names[2][BENCH_NAME_MAX];
+    unsigned nthreads = 0;
+    const char *lexicon = NULL;
+    const char *write = NULL;
+    corpus_t corpus;
+    uint64_t *samples;
+    size_t lines = BENCH_LINES;
+    size_t rounds = BENCH_ROUNDS;
+    uint64_t seed = BENCH_SEED;
+    bool csv = false;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "n:r:s:f:l:t:w:h", options,
+                              NULL)) != -1) {
+        switch (opt) {
+            case 'n':
+                lines = strtoul(optarg, NULL, 10);
+                break;
+
+            case 'r':
+                rounds = strtoul(optarg, NULL, 10);
+                break;
+
+            case 's':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+
+            case 'f':
+                csv = strcmp(optarg, "csv") == 0;
+                break;
+
+            case 'l':
+                lexicon = optarg;
+                break;
+
+            case 't':
+                if (!bench_threads(optarg, &nthreads)) {
+                    usage(stderr, argv[0]);
+                    return 1;
+                }
+                break;
+
+            case 'w':
+                write = optarg;
+                break;
+
+            case 'h':
+                usage(stdout, argv[0]);
+                return 0;
+
+            default:
+                usage(stderr, argv[0]);
+                return 1;
+        }
+    }
+    if (lines == 0 || rounds == 0) {
+        usage(stderr, argv[0]);
+        return 1;
+    }
+
+    if ((lexicon ? parser_load(lexicon) : parser_init()) != 0) {
+        fprintf(stderr, "%s: can't load the lexicon\n", argv[0]);
+        return 1;
+    }
+    if (bench_words_init() != 0) {
+        fprintf(stderr, "%s: the lexicon has no words of some category\n",
+                argv[0]);
+        bench_words_destroy();
+        parser_destroy();
+        return 1;
+    }
+    if (corpus_init(&corpus, lines, seed) != 0) {
+        fprintf(stderr, "%s: can't generate the corpus\n", argv[0]);
+        bench_words_destroy();
+        corpus_destroy(&corpus);
+        parser_destroy();
+        return 1;
+    }
+    bench_words_destroy();   /* the corpus has its own copy of the words */
+    if (write) {
+        int ret_val = bench_write(&corpus, write);
+        corpus_destroy(&corpus);
+        parser_destroy();
+        return ret_val;
+    }
+
+    if (!(samples = malloc(sizeof(uint64_t) * lines * rounds))) {
+        parser_destroy();
+        corpus_destroy(&corpus);
+        return 1;
+    }
+
+    for (size_t b = 0; b < arr_len(benchmarks); ++b) {
+        bench_run(&corpus, b, rounds, samples, &results[b]);
+    }
+    if (!nthreads) {
+        long ncores = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = ncores <= 0 ? 1 : ncores < BATCH_THREADS_MAX ?
+                   (unsigned) ncores : BATCH_THREADS_MAX;
+    }
+    if (bench_batch(&corpus, 1, rounds, samples,
+                    &results[arr_len(benchmarks)], names[0]) != 0 ||
+            bench_batch(&corpus, nthreads, rounds, samples,
+                        &results[arr_len(benchmarks) + 1], names[1]) != 0) {
+        fprintf(stderr, "%s: can't run the batches\n", argv[0]);
+        free(samples);
+        parser_destroy();
+        corpus_destroy(&corpus);
+        return 1;
+    }
+    bench_print(results, arr_len(results), &corpus, seed, csv);
+
+    free(samples);
+    parser_destroy();
+    corpus_destroy(&corpus);
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2019, J. A. Corbal
+ *
+ * THIS MATERIAL IS PROVIDED "AS IS", WITH ABSOLUTELY NO WARRANTY
+ * EXPRESSED OR IMPLIED.  ANY USE IS AT YOUR OWN RISK.
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear in
+ * supporting documentation.  No representations are made about the
+ * suitability of this software for any purpose.
+ */
+/**
+ * @file mklex.c
+ *
+ * @brief Compiles a text lexicon into a binary lexicon file
+ *
+ * Every line of the text lexicon is a category followed by the words
+ * in it, separated by blanks.  Empty lines and lines starting with '#'
+ * are ignored.
+ *
+ * @see lexicon_read
+ *
+ * @code
+ * $ mklex data/lexicon.txt bin/lexicon.bin
+ * @endcode
+ *
+ * @see lexfile.h
+ */
+
+/* System includes */
+#include <stdio.h>      /* fprintf, fopen, fread */
+#include <stdlib.h>     /* realloc, free */
+
+/* Local includes */
+#include <lexfile.h>
+#include <lexicon.h>
+#include <parser.h>
+#include <tokenizer.h>
+
+#define MKLEX_CHUNK  (4096)     /**< Bytes read at once */
+
+
+/* Reads every word of a text lexicon */
+static int mklex_read(lexicon_t *lexicon, FILE *fp, const char *path)
+{
+    char *text = NULL;
+    size_t len = 0;
+    size_t got;
+    size_t lineno;
+
+    do {
+        char *p;
+        if (!(p = realloc(text, len + MKLEX_CHUNK))) {
+            free(text);
+            return 1;
+        }
+        text = p;
+        got = fread(text + len, 1, MKLEX_CHUNK, fp);
+        len += got;
+    } while (got == MKLEX_CHUNK);
+
+    if ((lineno = lexicon_read(lexicon, text, len)) != 0) {
+        fprintf(stderr, "%s:%zu: unknown category or invalid word\n",
+                path, lineno);
+    }
+    free(text);
+
+    return lineno != 0;
+}
+
+
+/* Main entry */
+int main(int argc, char *argv[])
+{
+    lexicon_t *lexicon;
+    tokenizer_t *tokenizer = NULL;
+    FILE *fp;
+    int ret_val = 1;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s LEXICON.txt LEXICON.bin\n", argv[0]);
+        return 1;
+    }
+
+    if (!(fp = fopen(argv[1], "r"))) {
+        perror(argv[1]);
+        return 1;
+    }
+    if (!(lexicon = lexicon_init())) {
+        fclose(fp);
+        return 1;
+    }
+
+    if (mklex_read(lexicon, fp, argv[1]) == 0 && lexicon_build(lexicon) &&
+            (tokenizer = tokenizer_init(lexicon, DELIMITERS))) {
+        if (lexfile_save(argv[2], lexicon, tokenizer)) {
+            ret_val = 0;
+        } else {
+            perror(argv[2]);
+        }
+    }
+
+    if (tokenizer) {
+        tokenizer_destroy(tokenizer);
+    }
+    lexicon_destroy(lexicon);
+    fclose(fp);
+
+    return ret_val;
+}